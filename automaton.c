@@ -0,0 +1,393 @@
+#include "automaton.h"
+#include "parser.h"
+#include "utils.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Плоскость типов клеток: столбец x - байты [1..height], в [0] и [height + 1] -
+// соседние по тору клетки того же столбца. Столбец длиннее поля, чтобы векторный
+// цикл считал хвост без отдельной ветки
+typedef unsigned char AutomatonPlane[MAX_WIDTH][AUTOMATON_STRIDE];
+
+typedef struct {
+    AutomatonPool* pool;
+    int band;
+} AutomatonWorker;
+
+// Пул потоков TICK. Рабочие потоки живут между командами и ждут следующего
+// запуска, основной поток считает полосу 0
+struct AutomatonPool {
+    // Текущий запуск (пишется основным потоком под mutex перед сменой job)
+    const AutomatonRules* table;
+    AutomatonPlane* planes;     // Поколение g читается из planes[g & 1], пишется в другую
+    int width, height;
+    int generations;
+    unsigned char changed[2][AUTOMATON_MAX_THREADS];  // Полоса изменилась в поколении g (по g & 1)
+
+    int threads;                // Полос: основной поток и запущенные рабочие
+    int requested;              // Число потоков, для которого создан пул
+    pthread_t handles[AUTOMATON_MAX_THREADS];
+    AutomatonWorker workers[AUTOMATON_MAX_THREADS];
+    pthread_barrier_t barrier;
+    pthread_mutex_t mutex;
+    pthread_cond_t start_cond;
+    unsigned long job;          // Номер запуска: рабочие ждут его изменения
+    int quit;
+};
+
+// Правила по умолчанию
+void automaton_default_rules(AutomatonRules* table) {
+    static const AutomatonRule defaults[] = {
+        { CELL_EMPTY, CELL_TREE, 2, DIR_UNKNOWN, CELL_TREE },   // Деревья разрастаются в пустые клетки
+        { CELL_HOLE, CELL_STONE, 1, DIR_UP, CELL_EMPTY },       // Камень сверху засыпает яму
+        { CELL_STONE, CELL_HOLE, 1, DIR_DOWN, CELL_EMPTY },     // и уходит из своей клетки
+    };
+
+    table->count = sizeof(defaults) / sizeof(defaults[0]);
+    memcpy(table->rules, defaults, sizeof(defaults));
+    table->threads = 0;
+}
+
+// Символ, допустимый в правиле: динозавр и цвета правилами не меняются
+static int automaton_valid_symbol(char symbol) {
+    return (cell_flags((CellType)symbol) & CELL_FLAG_OBJECT) != 0;
+}
+
+// Загрузка таблицы правил: строки "from neighbor count to" или "from neighbor DIRECTION to",
+// например "_ & 2 &" или "% @ UP _". Комментарии начинаются с //
+int automaton_load_rules(AutomatonRules* table, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+
+    AutomatonRules loaded;
+    loaded.count = 0;
+    loaded.threads = table->threads;
+
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int result = 0;
+    while (read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+        char from[8], neighbor[8], condition[16], to[8];
+        char* text = line;
+        while (*text == ' ' || *text == '\t') text++;
+        if (*text == '\0' || (text[0] == '/' && text[1] == '/')) {
+            continue;
+        }
+
+        int fields = sscanf(text, "%7s %7s %15s %7s", from, neighbor, condition, to);
+        AutomatonRule* rule = &loaded.rules[loaded.count];
+        rule->direction = DIR_UNKNOWN;
+        rule->count = 1;
+        if (fields == 4 && strlen(from) == 1 && strlen(neighbor) == 1 && strlen(to) == 1) {
+            rule->from = from[0];
+            rule->neighbor = neighbor[0];
+            rule->to = to[0];
+            rule->direction = parse_direction(condition);
+            if (rule->direction == DIR_UNKNOWN) {
+                rule->count = atoi(condition);
+            }
+        }
+        if (fields != 4 || !automaton_valid_symbol(rule->from) || !automaton_valid_symbol(rule->to) ||
+            (!automaton_valid_symbol(rule->neighbor) && rule->neighbor != CELL_DINO) ||
+            rule->count < 1 || rule->count > 4) {
+            printf("Syntax Error: line %d in %s must be 'from neighbor count|direction to' (symbols _%%^&@, count 1..4)\n",
+                   line_number, filename);
+            result = -1;
+            break;
+        }
+        if (++loaded.count == AUTOMATON_MAX_RULES) {
+            printf("Error: Too many rules in %s (max %d)\n", filename, AUTOMATON_MAX_RULES);
+            result = -1;
+            break;
+        }
+    }
+    fclose(file);
+
+    if (result == 0) {
+        *table = loaded;
+        printf("Rules loaded from '%s': %d rules\n", filename, loaded.count);
+    }
+    return result;
+}
+
+// Новое значение клетки по первому подходящему правилу (neighbors - по направлениям)
+static unsigned char automaton_cell(const AutomatonRules* table, unsigned char cell, const unsigned char neighbors[4]) {
+    for (int r = 0; r < table->count; r++) {
+        const AutomatonRule* rule = &table->rules[r];
+        if (cell != (unsigned char)rule->from) {
+            continue;
+        }
+        int matched;
+        if (rule->direction != DIR_UNKNOWN) {
+            matched = neighbors[rule->direction] == (unsigned char)rule->neighbor;
+        } else {
+            int count = 0;
+            for (int d = 0; d < 4; d++) {
+                count += neighbors[d] == (unsigned char)rule->neighbor;
+            }
+            matched = count >= rule->count;
+        }
+        if (matched) {
+            return (unsigned char)rule->to;
+        }
+    }
+    return cell;
+}
+
+// Следующее поколение столбца x
+static void automaton_column(const AutomatonRules* table, AutomatonPlane plane, unsigned char* out,
+                             int x, int width, int height) {
+    const unsigned char* column = plane[x];
+    const unsigned char* left = plane[(x + width - 1) % width];
+    const unsigned char* right = plane[(x + 1) % width];
+    int y = 0;
+
+#if defined(__SSE2__)
+    // 16 клеток за раз: для каждого правила маска совпавших клеток, первое правило побеждает
+    for (; y < height; y += 16) {
+        __m128i cell = _mm_loadu_si128((const __m128i*)(column + 1 + y));
+        __m128i neighbors[4];
+        neighbors[DIR_UP] = _mm_loadu_si128((const __m128i*)(column + y));
+        neighbors[DIR_DOWN] = _mm_loadu_si128((const __m128i*)(column + 2 + y));
+        neighbors[DIR_LEFT] = _mm_loadu_si128((const __m128i*)(left + 1 + y));
+        neighbors[DIR_RIGHT] = _mm_loadu_si128((const __m128i*)(right + 1 + y));
+
+        __m128i result = cell;
+        __m128i decided = _mm_setzero_si128();
+        for (int r = 0; r < table->count; r++) {
+            const AutomatonRule* rule = &table->rules[r];
+            __m128i neighbor = _mm_set1_epi8(rule->neighbor);
+            __m128i match = _mm_cmpeq_epi8(cell, _mm_set1_epi8(rule->from));
+            if (rule->direction != DIR_UNKNOWN) {
+                match = _mm_and_si128(match, _mm_cmpeq_epi8(neighbors[rule->direction], neighbor));
+            } else {
+                // Совпадение дает -1 в байте, поэтому вычитание считает соседей
+                __m128i count = _mm_setzero_si128();
+                for (int d = 0; d < 4; d++) {
+                    count = _mm_sub_epi8(count, _mm_cmpeq_epi8(neighbors[d], neighbor));
+                }
+                match = _mm_and_si128(match, _mm_cmpgt_epi8(count, _mm_set1_epi8((char)(rule->count - 1))));
+            }
+            match = _mm_andnot_si128(decided, match);
+            result = _mm_or_si128(_mm_andnot_si128(match, result), _mm_and_si128(match, _mm_set1_epi8(rule->to)));
+            decided = _mm_or_si128(decided, match);
+        }
+        _mm_storeu_si128((__m128i*)(out + 1 + y), result);
+    }
+#endif
+
+    // Скалярный вариант без SIMD
+    for (; y < height; y++) {
+        unsigned char neighbors[4];
+        neighbors[DIR_UP] = column[y];
+        neighbors[DIR_DOWN] = column[y + 2];
+        neighbors[DIR_LEFT] = left[y + 1];
+        neighbors[DIR_RIGHT] = right[y + 1];
+        out[y + 1] = automaton_cell(table, column[y + 1], neighbors);
+    }
+
+    out[0] = out[height];
+    out[height + 1] = out[1];
+}
+
+// Поколение generation для полосы столбцов. Каждый поток пишет только свои
+// столбцы новой плоскости, поэтому результат не зависит от числа потоков.
+// Возвращает 1, если в полосе изменилась хотя бы одна клетка
+static int automaton_band(AutomatonPool* pool, int band, int generation) {
+    int begin = pool->width * band / pool->threads;
+    int end = pool->width * (band + 1) / pool->threads;
+    AutomatonPlane* current = &pool->planes[generation & 1];
+    AutomatonPlane* next = &pool->planes[(generation + 1) & 1];
+    int changed = 0;
+
+    for (int x = begin; x < end; x++) {
+        automaton_column(pool->table, *current, (*next)[x], x, pool->width, pool->height);
+        changed |= memcmp((*current)[x] + 1, (*next)[x] + 1, pool->height) != 0;
+    }
+    return changed;
+}
+
+// Поколения запуска для полосы band. Поколение без изменений дальше ничего не
+// изменит, поэтому счет останавливается: после барьера все потоки видят одни и те же
+// флаги и выходят вместе. Флаги двойные - поколение g + 1 пишет другую строку, пока
+// отстающие потоки еще читают строку g. Число поколений читается до первого барьера:
+// после последнего основной поток уже может готовить следующий запуск.
+// Возвращает число посчитанных поколений
+static int automaton_generations(AutomatonPool* pool, int band) {
+    int generations = pool->generations;
+    for (int g = 0; g < generations; g++) {
+        pool->changed[g & 1][band] = (unsigned char)automaton_band(pool, band, g);
+        if (pool->threads > 1) {
+            pthread_barrier_wait(&pool->barrier);
+        }
+        if (g + 1 == generations) {
+            break;
+        }
+
+        int changed = 0;
+        for (int t = 0; t < pool->threads; t++) {
+            changed |= pool->changed[g & 1][t];
+        }
+        if (!changed) {
+            // Следующий запуск начнет писать флаги, когда все потоки их уже прочитали
+            if (pool->threads > 1) {
+                pthread_barrier_wait(&pool->barrier);
+            }
+            return g + 1;
+        }
+    }
+    return generations;
+}
+
+static void* automaton_worker(void* arg) {
+    AutomatonWorker* worker = arg;
+    AutomatonPool* pool = worker->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while (pool->job == seen && !pool->quit) {
+            pthread_cond_wait(&pool->start_cond, &pool->mutex);
+        }
+        if (pool->quit) {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+        seen = pool->job;
+        pthread_mutex_unlock(&pool->mutex);
+
+        automaton_generations(pool, worker->band);
+    }
+}
+
+// Пул на threads потоков. Если часть потоков не запустилась, полос столько,
+// сколько реально работает
+static AutomatonPool* automaton_pool_create(int threads) {
+    AutomatonPool* pool = calloc(1, sizeof(AutomatonPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->requested = threads;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start_cond, NULL);
+
+    // Рабочие ждут смены job, поэтому барьер можно создать после их запуска
+    int created = 1;
+    for (int t = 1; t < threads; t++) {
+        pool->workers[t].pool = pool;
+        pool->workers[t].band = t;
+        if (pthread_create(&pool->handles[t], NULL, automaton_worker, &pool->workers[t]) != 0) {
+            break;
+        }
+        created++;
+    }
+    pool->threads = created;
+    pthread_barrier_init(&pool->barrier, NULL, created);
+    return pool;
+}
+
+// Остановка рабочих потоков и освобождение пула (interpreter_free)
+void automaton_pool_destroy(AutomatonPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->mutex);
+    for (int t = 1; t < pool->threads; t++) {
+        pthread_join(pool->handles[t], NULL);
+    }
+    pthread_barrier_destroy(&pool->barrier);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool);
+}
+
+// Выполнение generations поколений. Клетки меняются через field_set_cell
+// (хеш и индексы IF COUNT/NEAREST обновляются). Пул потоков создается в *pool при
+// первом многопоточном запуске и переиспользуется следующими. Возвращает число
+// измененных клеток
+long automaton_run(const AutomatonRules* table, AutomatonPool** pool, Field* field, int generations) {
+    if (generations <= 0 || field->width == 0 || field->height == 0) {
+        return 0;
+    }
+
+    int threads = table->threads > 0 ? table->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > AUTOMATON_MAX_THREADS) threads = AUTOMATON_MAX_THREADS;
+    if (threads > field->width) threads = field->width;
+    if (threads < 1 || field->width * field->height < AUTOMATON_PARALLEL_CELLS) threads = 1;
+
+    // Малые поля считаются в основном потоке без пула
+    AutomatonPool single;
+    AutomatonPool* run = &single;
+    single.threads = 1;
+    if (threads > 1) {
+        if (*pool != NULL && (*pool)->requested != threads) {
+            automaton_pool_destroy(*pool);
+            *pool = NULL;
+        }
+        if (*pool == NULL) {
+            *pool = automaton_pool_create(threads);
+            if (*pool == NULL) {
+                printf("Error: Cannot allocate automaton threads\n");
+                return -1;
+            }
+        }
+        run = *pool;
+    }
+
+    AutomatonPlane* planes = malloc(2 * sizeof(AutomatonPlane));
+    if (planes == NULL) {
+        printf("Error: Cannot allocate automaton planes\n");
+        return -1;
+    }
+
+    AutomatonPlane* first = &planes[0];
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            (*first)[x][y + 1] = (unsigned char)field->grid[x][y].type;
+        }
+        (*first)[x][0] = (*first)[x][field->height];
+        (*first)[x][field->height + 1] = (*first)[x][1];
+    }
+
+    if (run != &single) {
+        pthread_mutex_lock(&run->mutex);
+    }
+    run->table = table;
+    run->planes = planes;
+    run->width = field->width;
+    run->height = field->height;
+    run->generations = generations;
+    if (run != &single) {
+        run->job++;
+        pthread_cond_broadcast(&run->start_cond);
+        pthread_mutex_unlock(&run->mutex);
+    }
+    int computed = automaton_generations(run, 0);
+
+    AutomatonPlane* last = &planes[computed & 1];
+    long changed = 0;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            Cell cell = field->grid[x][y];
+            if ((unsigned char)cell.type != (*last)[x][y + 1]) {
+                cell.type = (CellType)(*last)[x][y + 1];
+                field_set_cell(field, x, y, cell);
+                changed++;
+            }
+        }
+    }
+
+    free(planes);
+    return changed;
+}
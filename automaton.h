@@ -0,0 +1,38 @@
+#ifndef AUTOMATON_H
+#define AUTOMATON_H
+
+#include "field.h"
+
+#define AUTOMATON_MAX_RULES 32
+#define AUTOMATON_MAX_THREADS 64
+#define AUTOMATON_PARALLEL_CELLS 2500   // Меньшие поля считаются в одном потоке
+#define AUTOMATON_STRIDE 128            // Байт на столбец в плоскости (запас для векторного хвоста)
+
+// Правило клеточного автомата (TICK): клетка from становится to, если среди
+// четырех соседей не меньше count клеток neighbor, или, если задано направление,
+// сосед с этой стороны - neighbor. Применяется первое подходящее правило
+typedef struct {
+    char from;
+    char neighbor;
+    int count;
+    int direction;          // DIR_UP..DIR_RIGHT или DIR_UNKNOWN - любые соседи
+    char to;
+} AutomatonRule;
+
+// Таблица правил
+typedef struct {
+    AutomatonRule rules[AUTOMATON_MAX_RULES];
+    int count;
+    int threads;            // Потоков для больших полей (0 - по числу процессоров)
+} AutomatonRules;
+
+// Пул потоков TICK (создается при первом многопоточном TICK, живет в контексте)
+typedef struct AutomatonPool AutomatonPool;
+
+// Функции автомата
+void automaton_default_rules(AutomatonRules* table);
+int automaton_load_rules(AutomatonRules* table, const char* filename);
+long automaton_run(const AutomatonRules* table, AutomatonPool** pool, Field* field, int generations);
+void automaton_pool_destroy(AutomatonPool* pool);
+
+#endif
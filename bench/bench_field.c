@@ -0,0 +1,314 @@
+// Микробенчмарки операций поля, истории UNDO и парсера.
+//
+// Сборка (из корня репозитория):
+//   gcc -O2 -I. bench/bench_field.c field.c interpreter.c parser.c commands.c utils.c stats.c trace.c profile.c pathfind.c counts.c scriptcache.c memo.c automaton.c pattern.c liveview.c -o bench_field
+//
+// Запуск:
+//   ./bench_field [--json results.json] [--min-time seconds]
+//
+// Каждый замер повторяется, пока не наберется min-time секунд (по умолчанию 0.2).
+// Таблица выводится в консоль, JSON с теми же данными - в файл для сравнения прогонов.
+
+#include "field.h"
+#include "parser.h"
+#include "interpreter.h"
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_RESULTS 64
+
+// Результат одного замера
+typedef struct {
+    char name[64];
+    int size;               // Размер поля (0 - не зависит от поля)
+    long iterations;
+    double ns_per_op;
+    long bytes_per_op;      // Байт скопировано за операцию (снимки поля)
+} BenchResult;
+
+// Операция под замером: выполняется iterations раз над общим состоянием
+typedef void (*BenchFunc)(long iterations);
+
+static BenchResult results[MAX_RESULTS];
+static int result_count = 0;
+static double min_time = 0.2;
+static int saved_stdout = -1;
+
+static Field bench_field;
+static InterpreterContext bench_context;
+static ParsedCommand bench_command;
+static const char* bench_line = NULL;
+static int bench_size = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Функции поля печатают в stdout - на время замеров вывод уходит в /dev/null
+static void mute_stdout(void) {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+}
+
+static void unmute_stdout(void) {
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+// Пустое поле size x size с динозавром в центре
+static void setup_field(Field* field, int size) {
+    field_init(field);
+    field_set_size(field, size, size);
+    field_set_dino_position(field, size / 2, size / 2);
+}
+
+// Запуск замера с подбором количества итераций
+static void run_bench(const char* name, int size, long bytes_per_op, BenchFunc func) {
+    long iterations = 1;
+    double elapsed = 0.0;
+
+    mute_stdout();
+    func(1);  // Прогрев
+    for (;;) {
+        double start = now_seconds();
+        func(iterations);
+        elapsed = now_seconds() - start;
+        if (elapsed >= min_time || iterations >= (1L << 30)) {
+            break;
+        }
+        iterations *= 2;
+    }
+    unmute_stdout();
+
+    if (result_count >= MAX_RESULTS) {
+        return;
+    }
+    BenchResult* result = &results[result_count++];
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    result->size = size;
+    result->iterations = iterations;
+    result->ns_per_op = elapsed / iterations * 1e9;
+    result->bytes_per_op = bytes_per_op;
+}
+
+// MOVE туда и обратно по пустому полю
+static void bench_move(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        field_move_dino(&bench_field, (i & 1) ? -1 : 1, 0);
+    }
+}
+
+// Короткий прыжок на 2 клетки туда и обратно
+static void bench_jump_short(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        field_jump_dino(&bench_field, (i & 1) ? -1 : 1, 0, 2);
+    }
+}
+
+// Прыжок с переходом через край поля (почти полный оборот)
+static void bench_jump_wrap(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        field_jump_dino(&bench_field, 1, 0, bench_size - 1);
+    }
+}
+
+// Пинок камня с возвратом камня на место
+static void bench_push(long iterations) {
+    int x = bench_field.dino_x;
+    int y = bench_field.dino_y;
+    for (long i = 0; i < iterations; i++) {
+        field_set_cell(&bench_field, x + 1, y, (Cell){ CELL_STONE, '\0' });
+        field_set_cell(&bench_field, x + 2, y, (Cell){ CELL_EMPTY, '\0' });
+        field_push_stone(&bench_field, 1, 0);
+    }
+}
+
+// Создание дерева с очисткой клетки
+static void bench_create(long iterations) {
+    int x = bench_field.dino_x;
+    int y = bench_field.dino_y;
+    for (long i = 0; i < iterations; i++) {
+        field_set_cell(&bench_field, x, y + 1, (Cell){ CELL_EMPTY, '\0' });
+        field_create_object(&bench_field, 0, 1, CELL_TREE);
+    }
+}
+
+static void bench_copy(long iterations) {
+    static Field copy;
+    for (long i = 0; i < iterations; i++) {
+        field_copy(&copy, &bench_field);
+    }
+}
+
+// Изменение одной клетки в углу поля (как после команды), чтобы
+// сохранение не совпало с последним снимком и копировало поле
+static void touch_context_field(void) {
+    Field* field = &bench_context.field;
+    CellType type = field->grid[0][0].type == CELL_TREE ? CELL_EMPTY : CELL_TREE;
+    field_set_cell(field, 0, 0, (Cell){ type, '\0' });
+}
+
+// Сохранение измененного поля при заполненной истории (самый частый случай)
+static void bench_save_state(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        touch_context_field();
+        interpreter_save_state(&bench_context);
+    }
+}
+
+// Сохранение без изменений поля: новый уровень ссылается на последний снимок
+static void bench_save_elided(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        interpreter_save_state(&bench_context);
+    }
+}
+
+// Пара "сохранение + откат" для измененного поля
+static void bench_save_undo(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        touch_context_field();
+        interpreter_save_state(&bench_context);
+        interpreter_undo(&bench_context);
+    }
+}
+
+static void bench_parse(long iterations) {
+    for (long i = 0; i < iterations; i++) {
+        parse_line(bench_line, &bench_command);
+    }
+}
+
+// Контекст с полем size x size и заполненной историей
+static void setup_context(int size) {
+    interpreter_init(&bench_context);
+    interpreter_set_display_options(&bench_context, 0, 0.0);
+    setup_field(&bench_context.field, size);
+    bench_context.field_initialized = 1;
+    bench_context.dino_placed = 1;
+    for (int i = 0; i < MAX_UNDO_LEVELS; i++) {
+        interpreter_save_state(&bench_context);
+    }
+}
+
+static void write_json(FILE* output) {
+    fprintf(output, "{\n  \"benchmarks\": [\n");
+    for (int i = 0; i < result_count; i++) {
+        BenchResult* result = &results[i];
+        fprintf(output,
+                "    {\"name\": \"%s\", \"size\": %d, \"iterations\": %ld, "
+                "\"ns_per_op\": %.2f, \"bytes_per_op\": %ld}%s\n",
+                result->name, result->size, result->iterations,
+                result->ns_per_op, result->bytes_per_op,
+                (i + 1 < result_count) ? "," : "");
+    }
+    fprintf(output, "  ]\n}\n");
+}
+
+static void print_table(void) {
+    printf("%-30s %6s %12s %12s %12s\n", "benchmark", "size", "iterations", "ns/op", "bytes/op");
+    for (int i = 0; i < result_count; i++) {
+        BenchResult* result = &results[i];
+        printf("%-30s %6d %12ld %12.1f %12ld\n", result->name, result->size,
+               result->iterations, result->ns_per_op, result->bytes_per_op);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const char* json_filename = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_filename = argv[++i];
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else {
+            printf("Usage: %s [--json results.json] [--min-time seconds]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    const int sizes[] = { MIN_SIZE, 50, MAX_WIDTH };
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_size = sizes[i];
+        // field_copy копирует только активную область size x size
+        const long region = (long)bench_size * bench_size * (long)sizeof(Cell);
+
+        mute_stdout();
+        setup_field(&bench_field, bench_size);
+        unmute_stdout();
+        run_bench("field_move_dino", bench_size, 0, bench_move);
+        run_bench("field_jump_dino/short", bench_size, 0, bench_jump_short);
+        run_bench("field_jump_dino/wrap", bench_size, 0, bench_jump_wrap);
+
+        mute_stdout();
+        setup_field(&bench_field, bench_size);
+        unmute_stdout();
+        run_bench("field_push_stone", bench_size, 0, bench_push);
+        run_bench("field_create_object", bench_size, 0, bench_create);
+        run_bench("field_copy", bench_size, region, bench_copy);
+
+        mute_stdout();
+        setup_context(bench_size);
+        unmute_stdout();
+        // Сохранение копирует активную область в свободный снимок (номера уровней
+        // сдвигаются без копирования), откат копирует ее обратно
+        run_bench("interpreter_save_state", bench_size, region, bench_save_state);
+        run_bench("interpreter_save_state/elided", bench_size, 0, bench_save_elided);
+        run_bench("interpreter_save_state+undo", bench_size, region * 2, bench_save_undo);
+    }
+
+    // Парсер не зависит от размера поля
+    static const struct {
+        const char* name;
+        const char* line;
+    } parse_cases[] = {
+        { "parse_line/COMMENT", "// comment line" },
+        { "parse_line/SIZE", "SIZE 100 100" },
+        { "parse_line/START", "START 5 5" },
+        { "parse_line/MOVE", "MOVE RIGHT" },
+        { "parse_line/PAINT", "PAINT a" },
+        { "parse_line/DIG", "DIG UP" },
+        { "parse_line/MOUND", "MOUND DOWN" },
+        { "parse_line/JUMP", "JUMP LEFT 7" },
+        { "parse_line/GROW", "GROW RIGHT" },
+        { "parse_line/CUT", "CUT RIGHT" },
+        { "parse_line/MAKE", "MAKE LEFT" },
+        { "parse_line/PUSH", "PUSH UP" },
+        { "parse_line/EXEC", "EXEC helper.txt" },
+        { "parse_line/LOAD", "LOAD field.txt" },
+        { "parse_line/UNDO", "UNDO" },
+        { "parse_line/IF", "IF CELL 3 4 IS & THEN CUT RIGHT" },
+    };
+    for (size_t i = 0; i < sizeof(parse_cases) / sizeof(parse_cases[0]); i++) {
+        bench_line = parse_cases[i].line;
+        run_bench(parse_cases[i].name, 0, 0, bench_parse);
+    }
+
+    print_table();
+
+    if (json_filename != NULL) {
+        FILE* json_file = fopen(json_filename, "w");
+        if (json_file == NULL) {
+            printf("Error: Cannot create JSON file '%s'\n", json_filename);
+            return 1;
+        }
+        write_json(json_file);
+        fclose(json_file);
+        printf("Results saved to '%s'\n", json_filename);
+    }
+
+    return 0;
+}
@@ -0,0 +1,84 @@
+// Сравнение старого посимвольного вывода поля с field_render.
+//
+// Сборка (из корня репозитория):
+//   gcc -O2 -I. bench/bench_render.c field.c counts.c utils.c -o bench_render
+//   gcc -O2 -mavx2 -I. bench/bench_render.c field.c counts.c utils.c -o bench_render_avx2
+
+#include "field.h"
+#include <time.h>
+
+#define ITERATIONS 2000
+
+// Прежняя реализация field_print: отдельный вызов stdio на каждую клетку
+static void legacy_print(Field* field, FILE* output) {
+    for (int y = 0; y < field->height; y++) {
+        for (int x = 0; x < field->width; x++) {
+            Cell* cell = &field->grid[x][y];
+            if (cell->color != '\0') {
+                fprintf(output, "%c", cell->color);
+            } else {
+                fprintf(output, "%c", (char)cell->type);
+            }
+        }
+        fprintf(output, "\n");
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Заполнение поля случайными объектами и цветами
+static void fill_random(Field* field, int size) {
+    const char types[] = { CELL_EMPTY, CELL_EMPTY, CELL_EMPTY, CELL_HOLE,
+                           CELL_MOUNTAIN, CELL_TREE, CELL_STONE };
+
+    field_init(field);
+    field->width = size;
+    field->height = size;
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            field->grid[x][y].type = types[rand() % sizeof(types)];
+            if (rand() % 8 == 0) {
+                field->grid[x][y].color = 'a' + rand() % 26;
+            }
+        }
+    }
+}
+
+int main(void) {
+    static Field field;
+    const int sizes[] = { MIN_SIZE, 50, MAX_WIDTH };
+
+    FILE* sink = fopen("/dev/null", "w");
+    if (sink == NULL) {
+        printf("Error: Cannot open /dev/null\n");
+        return 1;
+    }
+
+    srand(42);
+    printf("%-6s %14s %14s %8s\n", "size", "legacy ns/op", "render ns/op", "speedup");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        fill_random(&field, sizes[i]);
+
+        double start = now_seconds();
+        for (int n = 0; n < ITERATIONS; n++) {
+            legacy_print(&field, sink);
+        }
+        double legacy = (now_seconds() - start) / ITERATIONS * 1e9;
+
+        start = now_seconds();
+        for (int n = 0; n < ITERATIONS; n++) {
+            field_print(&field, sink);
+        }
+        double render = (now_seconds() - start) / ITERATIONS * 1e9;
+
+        printf("%-6d %14.0f %14.0f %7.1fx\n", sizes[i], legacy, render, legacy / render);
+    }
+
+    fclose(sink);
+    return 0;
+}
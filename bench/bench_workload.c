@@ -0,0 +1,507 @@
+// Генератор сценариев и замер сквозной пропускной способности интерпретатора.
+//
+// Сборка (из корня репозитория):
+//   gcc -O2 *.c -o dino
+//   gcc -O2 -I. bench/bench_workload.c field.c counts.c utils.c -o bench_workload
+//
+// Запуск:
+//   ./bench_workload [--dino ./dino] [--seed N] [--commands N] [--dir workload]
+//                    [--json results.json] [--generate-only]
+//
+// Сценарии детерминированы: одинаковые seed и commands дают одинаковые скрипты.
+// Каждый скрипт выполняется настоящим бинарником (--no-display --timing),
+// в отчете - команды в секунду, пиковый RSS и разбивка времени.
+
+#include "field.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define WORKLOAD_FIELD_SIZE 100
+#define EXEC_CHAIN_DEPTH 9      // Интерпретатор допускает не более 10 уровней EXEC
+
+// Генератор: скрипт, модель поля для отбраковки фатальных команд, ГПСЧ
+typedef struct {
+    FILE* out;
+    Field model;
+    unsigned int rng;
+    long lines;
+} Generator;
+
+// Результат прогона одного сценария
+typedef struct {
+    const char* name;
+    long commands;
+    double wall_time;
+    double parse_time;
+    double execute_time;
+    double output_time;
+    long peak_rss_kb;
+    int exit_code;
+} RunResult;
+
+typedef struct {
+    const char* name;
+    int dx, dy;
+} GenDirection;
+
+static const GenDirection directions[] = {
+    { "UP", 0, -1 }, { "DOWN", 0, 1 }, { "LEFT", -1, 0 }, { "RIGHT", 1, 0 }
+};
+
+static int saved_stdout = -1;
+
+// Функции поля печатают в stdout - при генерации вывод уходит в /dev/null
+static void mute_stdout(void) {
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    if (null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+        close(null_fd);
+    }
+}
+
+static void unmute_stdout(void) {
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+        saved_stdout = -1;
+    }
+}
+
+// xorshift32 - детерминированный и одинаковый на всех платформах
+static unsigned int gen_next(Generator* gen) {
+    unsigned int x = gen->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    gen->rng = x;
+    return x;
+}
+
+static int gen_range(Generator* gen, int n) {
+    return (int)(gen_next(gen) % (unsigned int)n);
+}
+
+static void gen_line(Generator* gen, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(gen->out, format, args);
+    va_end(args);
+    fputc('\n', gen->out);
+    gen->lines++;
+}
+
+static int gen_open(Generator* gen, const char* dir, const char* filename, unsigned int seed) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, filename);
+    gen->out = fopen(path, "w");
+    if (gen->out == NULL) {
+        printf("Error: Cannot create '%s'\n", path);
+        return -1;
+    }
+    gen->rng = seed ? seed : 1;
+    gen->lines = 0;
+    return 0;
+}
+
+// SIZE + START на пустом поле
+static void gen_empty_field(Generator* gen) {
+    field_init(&gen->model);
+    field_set_size(&gen->model, WORKLOAD_FIELD_SIZE, WORKLOAD_FIELD_SIZE);
+    field_set_dino_position(&gen->model, WORKLOAD_FIELD_SIZE / 2, WORKLOAD_FIELD_SIZE / 2);
+    gen_line(gen, "SIZE %d %d", WORKLOAD_FIELD_SIZE, WORKLOAD_FIELD_SIZE);
+    gen_line(gen, "START %d %d", WORKLOAD_FIELD_SIZE / 2, WORKLOAD_FIELD_SIZE / 2);
+}
+
+// Случайное поле с препятствиями и ямами, сохраняется в файл для LOAD
+static int gen_random_field(Generator* gen, const char* dir, const char* filename, int obstacle_percent) {
+    const CellType obstacles[] = { CELL_MOUNTAIN, CELL_TREE, CELL_STONE, CELL_HOLE };
+    Field* field = &gen->model;
+
+    field_init(field);
+    field->width = WORKLOAD_FIELD_SIZE;
+    field->height = WORKLOAD_FIELD_SIZE;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            if (gen_range(gen, 100) < obstacle_percent) {
+                field->grid[x][y].type = obstacles[gen_range(gen, 4)];
+            }
+        }
+    }
+    field->dino_x = field->width / 2;
+    field->dino_y = field->height / 2;
+    field->grid[field->dino_x][field->dino_y].type = CELL_DINO;
+
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, filename);
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Error: Cannot create '%s'\n", path);
+        return -1;
+    }
+    field_print(field, file);
+    fclose(file);
+
+    gen_line(gen, "LOAD %s", filename);
+    return 0;
+}
+
+static CellType gen_cell_type(Generator* gen, int dx, int dy) {
+    Field* field = &gen->model;
+    return field_get_cell(field, field->dino_x + dx, field->dino_y + dy)->type;
+}
+
+// MOVE, если он не приводит в яму
+static int gen_move(Generator* gen, const GenDirection* dir) {
+    if (gen_cell_type(gen, dir->dx, dir->dy) == CELL_HOLE) {
+        return 0;
+    }
+    field_move_dino(&gen->model, dir->dx, dir->dy);
+    gen_line(gen, "MOVE %s", dir->name);
+    return 1;
+}
+
+// JUMP, если на пути нет ям (проверка с запасом)
+static int gen_jump(Generator* gen, const GenDirection* dir, int distance) {
+    for (int i = 1; i <= distance; i++) {
+        if (gen_cell_type(gen, dir->dx * i, dir->dy * i) == CELL_HOLE) {
+            return 0;
+        }
+    }
+    field_jump_dino(&gen->model, dir->dx, dir->dy, distance);
+    gen_line(gen, "JUMP %s %d", dir->name, distance);
+    return 1;
+}
+
+// Одна случайная команда изменения местности (или перемещение)
+static void gen_terrain_command(Generator* gen) {
+    const GenDirection* dir = &directions[gen_range(gen, 4)];
+    Field* field = &gen->model;
+
+    switch (gen_range(gen, 9)) {
+        case 0:
+            field_create_object(field, dir->dx, dir->dy, CELL_HOLE);
+            gen_line(gen, "DIG %s", dir->name);
+            break;
+        case 1:
+            field_create_object(field, dir->dx, dir->dy, CELL_MOUNTAIN);
+            gen_line(gen, "MOUND %s", dir->name);
+            break;
+        case 2:
+            field_create_object(field, dir->dx, dir->dy, CELL_TREE);
+            gen_line(gen, "GROW %s", dir->name);
+            break;
+        case 3:
+            field_create_object(field, dir->dx, dir->dy, CELL_STONE);
+            gen_line(gen, "MAKE %s", dir->name);
+            break;
+        case 4:
+            field_cut_tree(field, dir->dx, dir->dy);
+            gen_line(gen, "CUT %s", dir->name);
+            break;
+        case 5:
+            field_push_stone(field, dir->dx, dir->dy);
+            gen_line(gen, "PUSH %s", dir->name);
+            break;
+        case 6: {
+            char color = 'a' + gen_range(gen, 26);
+            field_paint_cell(field, color);
+            gen_line(gen, "PAINT %c", color);
+            break;
+        }
+        default:
+            gen_move(gen, dir);
+            break;
+    }
+}
+
+// Случайное блуждание по полю с препятствиями
+static void gen_walk(Generator* gen, long commands) {
+    while (gen->lines < commands) {
+        const GenDirection* dir = &directions[gen_range(gen, 4)];
+        if (gen_range(gen, 4) == 0) {
+            gen_jump(gen, dir, 1 + gen_range(gen, 8));
+        } else {
+            gen_move(gen, dir);
+        }
+    }
+}
+
+// Смесь DIG/MOUND/GROW/CUT/MAKE/PUSH/PAINT/MOVE
+static void gen_terrain(Generator* gen, long commands) {
+    while (gen->lines < commands) {
+        gen_terrain_command(gen);
+    }
+}
+
+// Команды IF со случайными условиями (примерно половина выполняется)
+static void gen_if_heavy(Generator* gen, long commands) {
+    static const char symbols[] = "_#%^&@abc";
+    Field* field = &gen->model;
+
+    while (gen->lines < commands) {
+        int x = gen_range(gen, field->width);
+        int y = gen_range(gen, field->height);
+        Cell* cell = field_get_cell(field, x, y);
+        char symbol;
+
+        if (gen_range(gen, 2) == 0) {
+            symbol = (cell->color != '\0') ? cell->color : (char)cell->type;
+        } else {
+            symbol = symbols[gen_range(gen, sizeof(symbols) - 1)];
+        }
+
+        const GenDirection* dir = &directions[gen_range(gen, 4)];
+        int condition_met = field_check_cell_symbol(field, x, y, symbol);
+
+        // THEN-команда не должна приводить к падению в яму
+        if (condition_met && gen_cell_type(gen, dir->dx, dir->dy) == CELL_HOLE) {
+            continue;
+        }
+        if (condition_met) {
+            field_move_dino(field, dir->dx, dir->dy);
+        }
+        gen_line(gen, "IF CELL %d %d IS %c THEN MOVE %s", x, y, symbol, dir->name);
+    }
+}
+
+// Цепочка вспомогательных файлов exec_chain_1.txt -> ... -> exec_chain_9.txt
+// Поле пустое, поэтому MOVE и PAINT в них безопасны из любой позиции
+static int gen_exec_chain(Generator* gen, const char* dir, long commands, unsigned int seed) {
+    for (int level = 1; level <= EXEC_CHAIN_DEPTH; level++) {
+        Generator helper;
+        char filename[64];
+        snprintf(filename, sizeof(filename), "exec_chain_%d.txt", level);
+        if (gen_open(&helper, dir, filename, seed + level) != 0) {
+            return -1;
+        }
+
+        gen_line(&helper, "// EXEC chain level %d", level);
+        for (int i = 0; i < 4; i++) {
+            gen_line(&helper, "MOVE %s", directions[gen_range(&helper, 4)].name);
+            gen_line(&helper, "PAINT %c", 'a' + gen_range(&helper, 26));
+        }
+        if (level < EXEC_CHAIN_DEPTH) {
+            gen_line(&helper, "EXEC exec_chain_%d.txt", level + 1);
+        }
+        fclose(helper.out);
+    }
+
+    gen_empty_field(gen);
+    while (gen->lines < commands) {
+        if (gen_range(gen, 8) == 0) {
+            gen_line(gen, "EXEC exec_chain_1.txt");
+        } else {
+            gen_line(gen, "MOVE %s", directions[gen_range(gen, 4)].name);
+        }
+    }
+    return 0;
+}
+
+// Генерация всех сценариев в каталог dir
+static int generate_workload(const char* dir, unsigned int seed, long commands) {
+    Generator gen;
+    int result = 0;
+
+    mkdir(dir, 0755);
+    mute_stdout();
+
+    if (gen_open(&gen, dir, "walk.txt", seed) == 0) {
+        result |= gen_random_field(&gen, dir, "walk_field.txt", 20);
+        gen_walk(&gen, commands);
+        fclose(gen.out);
+    } else {
+        result = -1;
+    }
+
+    if (gen_open(&gen, dir, "terrain.txt", seed + 100) == 0) {
+        gen_empty_field(&gen);
+        gen_terrain(&gen, commands);
+        fclose(gen.out);
+    } else {
+        result = -1;
+    }
+
+    if (gen_open(&gen, dir, "exec_chain.txt", seed + 200) == 0) {
+        result |= gen_exec_chain(&gen, dir, commands / 8, seed + 200);
+        fclose(gen.out);
+    } else {
+        result = -1;
+    }
+
+    if (gen_open(&gen, dir, "if_heavy.txt", seed + 300) == 0) {
+        result |= gen_random_field(&gen, dir, "if_field.txt", 10);
+        gen_if_heavy(&gen, commands);
+        fclose(gen.out);
+    } else {
+        result = -1;
+    }
+
+    unmute_stdout();
+    return result;
+}
+
+// Поиск строки "Timing:" в журнале прогона
+static void read_timing(const char* log_path, RunResult* result) {
+    FILE* log = fopen(log_path, "r");
+    if (log == NULL) {
+        return;
+    }
+
+    char line[512];
+    while (read_line(log, line, sizeof(line)) != NULL) {
+        if (strncmp(line, "Timing:", 7) == 0) {
+            sscanf(line, "Timing: commands=%ld parse=%lf execute=%lf output=%lf",
+                   &result->commands, &result->parse_time,
+                   &result->execute_time, &result->output_time);
+        }
+    }
+    fclose(log);
+}
+
+// Запуск бинарника на сценарии с замером времени и пикового RSS
+static int run_scenario(const char* dino, const char* dir, const char* name, RunResult* result) {
+    char script[PATH_MAX], output[PATH_MAX], log_path[PATH_MAX];
+    snprintf(script, sizeof(script), "%s.txt", name);
+    snprintf(output, sizeof(output), "%s.out", name);
+    snprintf(log_path, sizeof(log_path), "%s/%s.log", dir, name);
+
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+
+    fflush(stdout);
+    double start = get_time_seconds();
+    pid_t pid = fork();
+    if (pid < 0) {
+        printf("Error: fork failed\n");
+        return -1;
+    }
+
+    if (pid == 0) {
+        // Скрипты ссылаются на файлы по относительным путям
+        if (chdir(dir) != 0 || freopen(strrchr(log_path, '/') + 1, "w", stdout) == NULL) {
+            _exit(127);
+        }
+        execl(dino, dino, script, output, "--no-display", "--timing", (char*)NULL);
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        printf("Error: wait4 failed\n");
+        return -1;
+    }
+
+    result->wall_time = get_time_seconds() - start;
+    result->peak_rss_kb = usage.ru_maxrss;
+    result->exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    read_timing(log_path, result);
+    return 0;
+}
+
+static void write_json(FILE* output, const RunResult* results, int count, double throughput) {
+    fprintf(output, "{\n  \"throughput_commands_per_second\": %.1f,\n  \"scenarios\": [\n", throughput);
+    for (int i = 0; i < count; i++) {
+        const RunResult* r = &results[i];
+        fprintf(output,
+                "    {\"name\": \"%s\", \"commands\": %ld, \"wall_seconds\": %.6f, "
+                "\"parse_seconds\": %.6f, \"execute_seconds\": %.6f, \"output_seconds\": %.6f, "
+                "\"peak_rss_kb\": %ld, \"exit_code\": %d}%s\n",
+                r->name, r->commands, r->wall_time, r->parse_time, r->execute_time,
+                r->output_time, r->peak_rss_kb, r->exit_code, (i + 1 < count) ? "," : "");
+    }
+    fprintf(output, "  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* dino = "./dino";
+    const char* dir = "workload";
+    const char* json_filename = NULL;
+    unsigned int seed = 1;
+    long commands = 20000;
+    int generate_only = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dino") == 0 && i + 1 < argc) {
+            dino = argv[++i];
+        } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--commands") == 0 && i + 1 < argc) {
+            commands = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_filename = argv[++i];
+        } else if (strcmp(argv[i], "--generate-only") == 0) {
+            generate_only = 1;
+        } else {
+            printf("Usage: %s [--dino path] [--seed N] [--commands N] [--dir path] "
+                   "[--json file] [--generate-only]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (generate_workload(dir, seed, commands) != 0) {
+        return 1;
+    }
+    printf("Workload generated in '%s' (seed %u, %ld commands per scenario)\n", dir, seed, commands);
+    if (generate_only) {
+        return 0;
+    }
+
+    // Бинарник запускается из каталога сценариев - нужен абсолютный путь
+    char dino_path[PATH_MAX];
+    if (realpath(dino, dino_path) == NULL) {
+        printf("Error: Interpreter binary '%s' not found\n", dino);
+        return 1;
+    }
+
+    const char* scenarios[] = { "walk", "terrain", "exec_chain", "if_heavy" };
+    const int scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+    RunResult results[sizeof(scenarios) / sizeof(scenarios[0])];
+    long total_commands = 0;
+    double total_time = 0.0;
+
+    printf("%-12s %10s %10s %12s %10s %10s %10s %10s\n", "scenario", "commands", "wall s",
+           "commands/s", "parse s", "execute s", "output s", "peak KB");
+    for (int i = 0; i < scenario_count; i++) {
+        RunResult* r = &results[i];
+        if (run_scenario(dino_path, dir, scenarios[i], r) != 0) {
+            return 1;
+        }
+        if (r->exit_code != 0) {
+            printf("Warning: scenario '%s' exited with code %d\n", r->name, r->exit_code);
+        }
+
+        printf("%-12s %10ld %10.3f %12.0f %10.3f %10.3f %10.3f %10ld\n", r->name, r->commands,
+               r->wall_time, r->commands / r->wall_time, r->parse_time, r->execute_time,
+               r->output_time, r->peak_rss_kb);
+        total_commands += r->commands;
+        total_time += r->wall_time;
+    }
+
+    double throughput = total_commands / total_time;
+    printf("Throughput: %.0f commands/s\n", throughput);
+
+    if (json_filename != NULL) {
+        FILE* json_file = fopen(json_filename, "w");
+        if (json_file == NULL) {
+            printf("Error: Cannot create JSON file '%s'\n", json_filename);
+            return 1;
+        }
+        write_json(json_file, results, scenario_count, throughput);
+        fclose(json_file);
+        printf("Results saved to '%s'\n", json_filename);
+    }
+
+    return 0;
+}
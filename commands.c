@@ -37,4 +37,33 @@ int get_direction_offset(Direction dir, int* dx, int* dy) {
     }
     
     return 0;
+}
+
+// Название команды (для статистики и отчетов)
+const char* command_type_name(CommandType type) {
+    switch (type) {
+        case CMD_COMMENT: return "COMMENT";
+        case CMD_SIZE: return "SIZE";
+        case CMD_START: return "START";
+        case CMD_MOVE: return "MOVE";
+        case CMD_PAINT: return "PAINT";
+        case CMD_DIG: return "DIG";
+        case CMD_MOUND: return "MOUND";
+        case CMD_JUMP: return "JUMP";
+        case CMD_GROW: return "GROW";
+        case CMD_CUT: return "CUT";
+        case CMD_MAKE: return "MAKE";
+        case CMD_PUSH: return "PUSH";
+        case CMD_EXEC: return "EXEC";
+        case CMD_LOAD: return "LOAD";
+        case CMD_UNDO: return "UNDO";
+        case CMD_IF: return "IF";
+        case CMD_GOTO: return "GOTO";
+        case CMD_TICK: return "TICK";
+        case CMD_FILL: return "FILL";
+        case CMD_CLEAR: return "CLEAR";
+        case CMD_REPLACE: return "REPLACE";
+        case CMD_STAMP: return "STAMP";
+        default: return "UNKNOWN";
+    }
 }
\ No newline at end of file
@@ -19,7 +19,14 @@ typedef enum {
     CMD_EXEC,       // Выполнение файла
     CMD_LOAD,       // Загрузка поля из файла
     CMD_UNDO,       // Откат действия
-    CMD_IF          // Условная команда
+    CMD_IF,         // Условная команда
+    CMD_GOTO,       // Перемещение динозавра к клетке кратчайшим путем
+    CMD_TICK,       // Поколения клеточного автомата
+    CMD_FILL,       // Заливка области
+    CMD_CLEAR,      // Очистка области
+    CMD_REPLACE,    // Замена символа в области
+    CMD_STAMP,      // Вставка шаблона из файла
+    CMD_COUNT       // Количество типов команд
 } CommandType;
 
 // Перечисление направлений движения
@@ -34,5 +41,6 @@ typedef enum {
 // Функции для работы с командами
 Direction parse_direction(const char* dir_str);
 int get_direction_offset(Direction dir, int* dx, int* dy);
+const char* command_type_name(CommandType type);
 
 #endif
\ No newline at end of file
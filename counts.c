@@ -0,0 +1,270 @@
+#include "counts.h"
+
+// Номер дерева для символа: типы клеток, затем цвета a-z (-1 - символ не учитывается)
+static int counts_symbol_index(char symbol) {
+    switch (symbol) {
+        case CELL_EMPTY: return 0;
+        case CELL_DINO: return 1;
+        case CELL_HOLE: return 2;
+        case CELL_MOUNTAIN: return 3;
+        case CELL_TREE: return 4;
+        case CELL_STONE: return 5;
+    }
+    if (symbol >= 'a' && symbol <= 'z') {
+        return 6 + (symbol - 'a');
+    }
+    return -1;
+}
+
+// Создание счетчиков (строятся по полю при первом запросе)
+FieldCounts* counts_create(void) {
+    FieldCounts* counts = calloc(1, sizeof(FieldCounts));
+    if (counts == NULL) {
+        printf("Error: Cannot allocate region counts\n");
+        return NULL;
+    }
+    counts->dirty = 1;
+    return counts;
+}
+
+// Освобождение счетчиков
+void counts_destroy(FieldCounts* counts) {
+    free(counts);
+}
+
+// Поле заменено целиком - деревья будут перестроены при следующем запросе
+void counts_invalidate(FieldCounts* counts) {
+    if (counts != NULL) {
+        counts->dirty = 1;
+    }
+}
+
+// Бит клетки в битовой карте ее плитки
+static inline uint64_t counts_tile_bit(int x, int y) {
+    return 1ULL << (((x & (COUNTS_TILE_SIZE - 1)) << COUNTS_TILE_SHIFT) | (y & (COUNTS_TILE_SIZE - 1)));
+}
+
+// Прибавление delta к клетке (x, y) дерева symbol
+static void counts_add(FieldCounts* counts, int symbol, int x, int y, int delta) {
+    uint64_t* tile = &counts->tiles[symbol][x >> COUNTS_TILE_SHIFT][y >> COUNTS_TILE_SHIFT];
+    if (delta > 0) {
+        *tile |= counts_tile_bit(x, y);
+    } else {
+        *tile &= ~counts_tile_bit(x, y);
+    }
+    for (int i = x + 1; i <= counts->width; i += i & -i) {
+        for (int j = y + 1; j <= counts->height; j += j & -j) {
+            counts->tree[symbol][i][j] += delta;
+        }
+    }
+}
+
+// Смена символа клетки (тип или цвет): old_symbol -> new_symbol
+void counts_update(FieldCounts* counts, int x, int y, char old_symbol, char new_symbol) {
+    if (counts->dirty || old_symbol == new_symbol) {
+        return;
+    }
+    int old_index = counts_symbol_index(old_symbol);
+    int new_index = counts_symbol_index(new_symbol);
+    if (old_index >= 0) {
+        counts_add(counts, old_index, x, y, -1);
+    }
+    if (new_index >= 0) {
+        counts_add(counts, new_index, x, y, 1);
+    }
+}
+
+// Построение всех деревьев по полю за O(символы * W * H)
+static void counts_rebuild(FieldCounts* counts, const Field* field) {
+    int width = field->width;
+    int height = field->height;
+    counts->width = width;
+    counts->height = height;
+    memset(counts->tree, 0, sizeof(counts->tree));
+    memset(counts->tiles, 0, sizeof(counts->tiles));
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            const Cell* cell = &field->grid[x][y];
+            int type = counts_symbol_index((char)cell->type);
+            counts->tree[type][x + 1][y + 1]++;
+            counts->tiles[type][x >> COUNTS_TILE_SHIFT][y >> COUNTS_TILE_SHIFT] |= counts_tile_bit(x, y);
+            if (cell->color != '\0') {
+                int color = counts_symbol_index(cell->color);
+                if (color >= 0) {
+                    counts->tree[color][x + 1][y + 1]++;
+                    counts->tiles[color][x >> COUNTS_TILE_SHIFT][y >> COUNTS_TILE_SHIFT] |= counts_tile_bit(x, y);
+                }
+            }
+        }
+    }
+
+    // Каждый узел передает сумму родителю - сначала по y, затем по x
+    for (int s = 0; s < COUNTS_SYMBOLS; s++) {
+        for (int i = 1; i <= width; i++) {
+            for (int j = 1; j <= height; j++) {
+                int parent = j + (j & -j);
+                if (parent <= height) {
+                    counts->tree[s][i][parent] += counts->tree[s][i][j];
+                }
+            }
+        }
+        for (int i = 1; i <= width; i++) {
+            int parent = i + (i & -i);
+            if (parent <= width) {
+                for (int j = 1; j <= height; j++) {
+                    counts->tree[s][parent][j] += counts->tree[s][i][j];
+                }
+            }
+        }
+    }
+    counts->dirty = 0;
+}
+
+// Перестроение индексов, если поле менялось целиком
+static void counts_refresh(FieldCounts* counts, const Field* field) {
+    if (counts->dirty || counts->width != field->width || counts->height != field->height) {
+        counts_rebuild(counts, field);
+    }
+}
+
+// Сумма по прямоугольнику [0, x) x [0, y)
+static int counts_prefix(const FieldCounts* counts, int symbol, int x, int y) {
+    int sum = 0;
+    for (int i = x; i > 0; i -= i & -i) {
+        for (int j = y; j > 0; j -= j & -j) {
+            sum += counts->tree[symbol][i][j];
+        }
+    }
+    return sum;
+}
+
+// Сумма по прямоугольнику [x1, x2] x [y1, y2] без перехода через край
+static int counts_rect(const FieldCounts* counts, int symbol, int x1, int y1, int x2, int y2) {
+    return counts_prefix(counts, symbol, x2 + 1, y2 + 1) - counts_prefix(counts, symbol, x1, y2 + 1)
+         - counts_prefix(counts, symbol, x2 + 1, y1) + counts_prefix(counts, symbol, x1, y1);
+}
+
+// Количество клеток с символом (тип или цвет) в прямоугольнике от (x1, y1) до (x2, y2)
+// включительно. Координаты берутся по модулю размеров поля; если x1 > x2 (y1 > y2),
+// область проходит через край поля.
+int counts_query(FieldCounts* counts, const Field* field, int x1, int y1, int x2, int y2, char symbol) {
+    int index = counts_symbol_index(symbol);
+    if (index < 0) {
+        return 0;
+    }
+    counts_refresh(counts, field);
+
+    x1 = ((x1 % field->width) + field->width) % field->width;
+    x2 = ((x2 % field->width) + field->width) % field->width;
+    y1 = ((y1 % field->height) + field->height) % field->height;
+    y2 = ((y2 % field->height) + field->height) % field->height;
+
+    // Область через край делится на две полосы по каждой оси
+    int xs[2][2] = { { x1, x2 }, { 0, x2 } };
+    int ys[2][2] = { { y1, y2 }, { 0, y2 } };
+    int x_parts = 1, y_parts = 1;
+    if (x1 > x2) {
+        xs[0][1] = field->width - 1;
+        x_parts = 2;
+    }
+    if (y1 > y2) {
+        ys[0][1] = field->height - 1;
+        y_parts = 2;
+    }
+
+    int total = 0;
+    for (int i = 0; i < x_parts; i++) {
+        for (int j = 0; j < y_parts; j++) {
+            total += counts_rect(counts, index, xs[i][0], ys[j][0], xs[i][1], ys[j][1]);
+        }
+    }
+    return total;
+}
+
+// Расстояние по окружности длины size от точки p до отрезка [start, end]
+static int counts_ring_distance(int p, int start, int end, int size) {
+    if (p >= start && p <= end) {
+        return 0;
+    }
+    int before = (start - p + size) % size;
+    int after = (p - end + size) % size;
+    return before < after ? before : after;
+}
+
+// Плитка-кандидат для поиска ближайшей клетки
+typedef struct {
+    int distance;       // Нижняя граница расстояния до клеток плитки
+    int tile_x, tile_y;
+} CountsTile;
+
+static int counts_tile_compare(const void* a, const void* b) {
+    const CountsTile* left = a;
+    const CountsTile* right = b;
+    if (left->distance != right->distance) return left->distance - right->distance;
+    if (left->tile_x != right->tile_x) return left->tile_x - right->tile_x;
+    return left->tile_y - right->tile_y;
+}
+
+// Ближайшая к (x, y) клетка с символом (тип или цвет) по манхэттенскому расстоянию
+// на торе. Возвращает расстояние и координаты в found_x/found_y или -1, если таких
+// клеток нет. При равных расстояниях выбирается клетка с меньшими x, затем y.
+int counts_nearest(FieldCounts* counts, const Field* field, int x, int y, char symbol, int* found_x, int* found_y) {
+    static CountsTile candidates[COUNTS_TILES_X * COUNTS_TILES_Y];
+    int index = counts_symbol_index(symbol);
+    if (index < 0) {
+        return -1;
+    }
+    counts_refresh(counts, field);
+
+    int width = field->width;
+    int height = field->height;
+    int tiles_x = (width + COUNTS_TILE_SIZE - 1) / COUNTS_TILE_SIZE;
+    int tiles_y = (height + COUNTS_TILE_SIZE - 1) / COUNTS_TILE_SIZE;
+
+    // Непустые плитки по возрастанию нижней границы расстояния
+    int candidate_count = 0;
+    for (int tx = 0; tx < tiles_x; tx++) {
+        int x_start = tx * COUNTS_TILE_SIZE;
+        int x_end = (x_start + COUNTS_TILE_SIZE - 1 < width) ? x_start + COUNTS_TILE_SIZE - 1 : width - 1;
+        int dx = counts_ring_distance(x, x_start, x_end, width);
+        for (int ty = 0; ty < tiles_y; ty++) {
+            if (counts->tiles[index][tx][ty] == 0) {
+                continue;
+            }
+            int y_start = ty * COUNTS_TILE_SIZE;
+            int y_end = (y_start + COUNTS_TILE_SIZE - 1 < height) ? y_start + COUNTS_TILE_SIZE - 1 : height - 1;
+            CountsTile* candidate = &candidates[candidate_count++];
+            candidate->distance = dx + counts_ring_distance(y, y_start, y_end, height);
+            candidate->tile_x = tx;
+            candidate->tile_y = ty;
+        }
+    }
+    qsort(candidates, candidate_count, sizeof(CountsTile), counts_tile_compare);
+
+    // Плитки просматриваются, пока их нижняя граница не превысит найденное расстояние
+    int best = -1;
+    for (int i = 0; i < candidate_count && (best < 0 || candidates[i].distance <= best); i++) {
+        uint64_t bits = counts->tiles[index][candidates[i].tile_x][candidates[i].tile_y];
+        while (bits != 0) {
+            int bit = __builtin_ctzll(bits);
+            bits &= bits - 1;
+
+            int cx = candidates[i].tile_x * COUNTS_TILE_SIZE + (bit >> COUNTS_TILE_SHIFT);
+            int cy = candidates[i].tile_y * COUNTS_TILE_SIZE + (bit & (COUNTS_TILE_SIZE - 1));
+            int ddx = abs(cx - x);
+            int ddy = abs(cy - y);
+            if (width - ddx < ddx) ddx = width - ddx;
+            if (height - ddy < ddy) ddy = height - ddy;
+
+            int distance = ddx + ddy;
+            if (best < 0 || distance < best ||
+                (distance == best && (cx < *found_x || (cx == *found_x && cy < *found_y)))) {
+                best = distance;
+                *found_x = cx;
+                *found_y = cy;
+            }
+        }
+    }
+    return best;
+}
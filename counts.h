@@ -0,0 +1,31 @@
+#ifndef COUNTS_H
+#define COUNTS_H
+
+#include <stdint.h>
+#include "field.h"
+
+#define COUNTS_SYMBOLS 32   // 6 типов клеток + 26 цветов
+#define COUNTS_TILE_SHIFT 3 // Плитки 8x8 клеток для поиска ближайшей клетки
+#define COUNTS_TILE_SIZE (1 << COUNTS_TILE_SHIFT)
+#define COUNTS_TILES_X ((MAX_WIDTH + COUNTS_TILE_SIZE - 1) / COUNTS_TILE_SIZE)
+#define COUNTS_TILES_Y ((MAX_HEIGHT + COUNTS_TILE_SIZE - 1) / COUNTS_TILE_SIZE)
+
+// Индексы символов поля, обновляются мутаторами field_*:
+// количество клеток по прямоугольникам (IF COUNT) - двумерные деревья Фенвика,
+// ближайшая клетка (IF NEAREST) - битовые карты занятости по плиткам
+struct FieldCounts {
+    int dirty;              // Поле изменено целиком (LOAD/UNDO) - перестроить при запросе
+    int width, height;      // Размеры, для которых построены индексы
+    unsigned short tree[COUNTS_SYMBOLS][MAX_WIDTH + 1][MAX_HEIGHT + 1];
+    uint64_t tiles[COUNTS_SYMBOLS][COUNTS_TILES_X][COUNTS_TILES_Y]; // Бит (x % 8) * 8 + y % 8
+};
+
+// Функции счетчиков по областям
+FieldCounts* counts_create(void);
+void counts_destroy(FieldCounts* counts);
+void counts_invalidate(FieldCounts* counts);
+void counts_update(FieldCounts* counts, int x, int y, char old_symbol, char new_symbol);
+int counts_query(FieldCounts* counts, const Field* field, int x1, int y1, int x2, int y2, char symbol);
+int counts_nearest(FieldCounts* counts, const Field* field, int x, int y, char symbol, int* found_x, int* found_y);
+
+#endif
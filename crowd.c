@@ -0,0 +1,597 @@
+#include "crowd.h"
+#include "commands.h"
+#include "utils.h"
+#include <pthread.h>
+
+// Состояние пула потоков на время crowd_run
+typedef struct {
+    Crowd* crowd;
+    pthread_barrier_t barrier;
+    pthread_mutex_t mutex;      // Старт потоков: барьер создается после запуска всех потоков
+    pthread_cond_t ready_cond;
+    int ready;
+    int stop;
+} CrowdPool;
+
+typedef struct {
+    CrowdPool* pool;
+    int band;
+} CrowdWorker;
+
+// Создание толпы на поле (поле задается командами SIZE/LOAD в описании)
+Crowd* crowd_create(Field* field, int thread_count) {
+    Crowd* crowd = calloc(1, sizeof(Crowd));
+    if (crowd == NULL) {
+        printf("Error: Cannot allocate crowd\n");
+        return NULL;
+    }
+
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > CROWD_MAX_THREADS) thread_count = CROWD_MAX_THREADS;
+
+    crowd->field = field;
+    crowd->thread_count = thread_count;
+    for (int x = 0; x < MAX_WIDTH; x++) {
+        for (int y = 0; y < MAX_HEIGHT; y++) {
+            atomic_init(&crowd->claims[x][y], 0);
+        }
+    }
+    return crowd;
+}
+
+// Освобождение толпы и потоков команд
+void crowd_destroy(Crowd* crowd) {
+    if (crowd == NULL) return;
+
+    for (int i = 0; i < crowd->stream_count; i++) {
+        free(crowd->streams[i].commands);
+    }
+    free(crowd->dinos);
+    free(crowd->band_order);
+    free(crowd);
+}
+
+// Команды, которые может выполнять динозавр толпы
+static int crowd_command_allowed(CommandType type) {
+    switch (type) {
+        case CMD_MOVE: case CMD_JUMP: case CMD_PAINT: case CMD_DIG: case CMD_MOUND:
+        case CMD_GROW: case CMD_CUT: case CMD_MAKE: case CMD_PUSH:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+// Загрузка потока команд (один раз на файл, динозавры с одним файлом его разделяют)
+static const CrowdStream* crowd_get_stream(Crowd* crowd, const char* filename) {
+    for (int i = 0; i < crowd->stream_count; i++) {
+        if (strcmp(crowd->streams[i].filename, filename) == 0) {
+            return &crowd->streams[i];
+        }
+    }
+
+    if (crowd->stream_count >= CROWD_MAX_STREAMS) {
+        printf("Error: Too many crowd command files (max %d)\n", CROWD_MAX_STREAMS);
+        return NULL;
+    }
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return NULL;
+    }
+
+    CrowdStream* stream = &crowd->streams[crowd->stream_count];
+    int capacity = 0;
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+
+    strncpy(stream->filename, filename, sizeof(stream->filename) - 1);
+    stream->filename[sizeof(stream->filename) - 1] = '\0';
+    stream->commands = NULL;
+    stream->count = 0;
+
+    while (read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+
+        ParsedCommand cmd;
+        if (parse_line(line, &cmd) != 0) {
+            printf("Error parsing line %d in %s: %s\n", line_number, filename, line);
+            continue;
+        }
+        if (cmd.type == CMD_COMMENT) {
+            continue;
+        }
+        if (!crowd_command_allowed(cmd.type)) {
+            printf("Error: Command %s at line %d in %s is not supported for crowd dinos\n",
+                   command_type_name(cmd.type), line_number, filename);
+            fclose(file);
+            free(stream->commands);
+            return NULL;
+        }
+
+        if (stream->count >= capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ParsedCommand* commands = realloc(stream->commands, capacity * sizeof(ParsedCommand));
+            if (commands == NULL) {
+                printf("Error: Out of memory loading '%s'\n", filename);
+                fclose(file);
+                free(stream->commands);
+                return NULL;
+            }
+            stream->commands = commands;
+        }
+        stream->commands[stream->count++] = cmd;
+    }
+
+    fclose(file);
+    crowd->stream_count++;
+    return stream;
+}
+
+// Добавление динозавра в пустую клетку поля
+int crowd_add_dino(Crowd* crowd, int x, int y, const char* script_filename) {
+    Field* field = crowd->field;
+
+    if (field->width == 0 || field->height == 0) {
+        printf("Error: Field not initialized. Use SIZE or LOAD before DINO\n");
+        return -1;
+    }
+    if (x < 0 || x >= field->width || y < 0 || y >= field->height) {
+        printf("Error: Coordinates (%d, %d) out of field bounds %dx%d\n", x, y, field->width, field->height);
+        return -2;
+    }
+    if (field->grid[x][y].type != CELL_EMPTY) {
+        printf("Error: Cell (%d, %d) is not empty for dino\n", x, y);
+        return -3;
+    }
+    if (crowd->dino_count >= CROWD_MAX_DINOS) {
+        printf("Error: Too many dinos (max %d)\n", CROWD_MAX_DINOS);
+        return -4;
+    }
+
+    const CrowdStream* stream = crowd_get_stream(crowd, script_filename);
+    if (stream == NULL) {
+        return -5;
+    }
+
+    if (crowd->dinos == NULL) {
+        crowd->dinos = malloc(CROWD_MAX_DINOS * sizeof(CrowdDino));
+        crowd->band_order = malloc(CROWD_MAX_DINOS * sizeof(int));
+        if (crowd->dinos == NULL || crowd->band_order == NULL) {
+            printf("Error: Cannot allocate crowd dinos\n");
+            return -4;
+        }
+    }
+
+    CrowdDino* dino = &crowd->dinos[crowd->dino_count++];
+    memset(dino, 0, sizeof(*dino));
+    dino->x = x;
+    dino->y = y;
+    dino->alive = 1;
+    dino->stream = stream;
+    field->grid[x][y].type = CELL_DINO;
+    return 0;
+}
+
+// Загрузка описания толпы:
+//   SIZE w h | LOAD file   - поле (первой строкой)
+//   DINO x y script.txt    - динозавр и его поток команд
+int crowd_load(Crowd* crowd, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int result = 0;
+
+    while (result == 0 && read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+        trim_whitespace(line);
+        if (line[0] == '\0' || is_comment_line(line)) {
+            continue;
+        }
+
+        char keyword[16];
+        char argument[MAX_FILENAME_LENGTH];
+        int a, b;
+
+        if (sscanf(line, "%15s", keyword) != 1) {
+            continue;
+        }
+
+        if (strcasecmp(keyword, "SIZE") == 0 && sscanf(line, "%*s %d %d", &a, &b) == 2) {
+            result = field_set_size(crowd->field, a, b);
+        } else if (strcasecmp(keyword, "LOAD") == 0 && sscanf(line, "%*s %99s", argument) == 1) {
+            result = field_load_from_file(crowd->field, argument);
+        } else if (strcasecmp(keyword, "DINO") == 0 && sscanf(line, "%*s %d %d %99s", &a, &b, argument) == 3) {
+            result = crowd_add_dino(crowd, a, b, argument);
+        } else {
+            printf("Syntax Error: line %d in %s must be SIZE w h, LOAD file or DINO x y file\n",
+                   line_number, filename);
+            result = -2;
+        }
+
+        if (result != 0) {
+            printf("Error at line %d in %s\n", line_number, filename);
+        }
+    }
+
+    fclose(file);
+
+    if (result == 0) {
+        printf("Crowd loaded from '%s': %d dinos, %d command files\n",
+               filename, crowd->dino_count, crowd->stream_count);
+    }
+    return result;
+}
+
+// Захват клетки: побеждает динозавр с меньшим номером, независимо от порядка потоков
+static void crowd_claim(Crowd* crowd, int x, int y, unsigned long long key) {
+    _Atomic unsigned long long* slot = &crowd->claims[x][y];
+    unsigned long long current = atomic_load_explicit(slot, memory_order_relaxed);
+
+    while (current < key &&
+           !atomic_compare_exchange_weak_explicit(slot, &current, key,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static unsigned long long crowd_claim_key(const Crowd* crowd, int id) {
+    return ((unsigned long long)crowd->tick << 32) | (0xFFFFFFFFu - (unsigned int)id);
+}
+
+// Клетка непроходима для динозавров толпы (другие динозавры - тоже препятствие)
+static int crowd_is_obstacle(CellType type) {
+    return (cell_flags(type) & (CELL_FLAG_BLOCKS | CELL_FLAG_OCCUPIED)) != 0;
+}
+
+static void crowd_add_claim(CrowdIntent* intent, int x, int y) {
+    intent->claim_x[intent->claim_count] = x;
+    intent->claim_y[intent->claim_count] = y;
+    intent->claim_count++;
+}
+
+// Фаза 1: намерение динозавра по состоянию поля в начале такта (только чтение поля)
+static void crowd_plan(Crowd* crowd, int id) {
+    CrowdDino* dino = &crowd->dinos[id];
+    CrowdIntent* intent = &dino->intent;
+    const Field* field = crowd->field;
+    const ParsedCommand* cmd = &dino->stream->commands[dino->next_command++];
+    int dx = 0, dy = 0;
+
+    memset(intent, 0, sizeof(*intent));
+    intent->type = CMD_UNKNOWN;
+
+    if (cmd->type != CMD_PAINT &&
+        get_direction_offset(parse_direction(cmd->direction), &dx, &dy) != 0) {
+        return;  // Неверное направление - команда без эффекта
+    }
+
+    int tx = (dino->x + dx + field->width) % field->width;
+    int ty = (dino->y + dy + field->height) % field->height;
+    CellType target = field->grid[tx][ty].type;
+
+    switch (cmd->type) {
+        case CMD_MOVE:
+            if (cell_flags(target) & CELL_FLAG_FATAL) {
+                intent->fatal = 1;
+            } else if (crowd_is_obstacle(target)) {
+                return;
+            } else {
+                crowd_add_claim(intent, tx, ty);
+            }
+            break;
+
+        case CMD_JUMP: {
+            int distance = cmd->n;
+            for (int i = 1; i <= cmd->n; i++) {
+                int cx = (dino->x + dx * i + field->width * i) % field->width;
+                int cy = (dino->y + dy * i + field->height * i) % field->height;
+                CellType type = field->grid[cx][cy].type;
+                if (crowd_is_obstacle(type)) {
+                    distance = i - 1;
+                    break;
+                }
+                if (i == cmd->n && (cell_flags(type) & CELL_FLAG_FATAL)) {
+                    intent->fatal = 1;
+                }
+            }
+            if (distance <= 0) {
+                return;
+            }
+            tx = (dino->x + dx * distance + field->width * distance) % field->width;
+            ty = (dino->y + dy * distance + field->height * distance) % field->height;
+            if (!intent->fatal) {
+                crowd_add_claim(intent, tx, ty);
+            }
+            break;
+        }
+
+        case CMD_PAINT:
+            if (cmd->color < 'a' || cmd->color > 'z') {
+                return;
+            }
+            intent->color = cmd->color;
+            break;
+
+        case CMD_DIG: case CMD_MOUND: case CMD_GROW: case CMD_MAKE:
+            if (!(cell_flags(target) & CELL_FLAG_BUILDABLE)) {
+                return;
+            }
+            intent->create_type = (cmd->type == CMD_DIG) ? CELL_HOLE :
+                                  (cmd->type == CMD_MOUND) ? CELL_MOUNTAIN :
+                                  (cmd->type == CMD_GROW) ? CELL_TREE : CELL_STONE;
+            crowd_add_claim(intent, tx, ty);
+            break;
+
+        case CMD_CUT:
+            if (!(cell_flags(target) & CELL_FLAG_CUTTABLE)) {
+                return;
+            }
+            crowd_add_claim(intent, tx, ty);
+            break;
+
+        case CMD_PUSH: {
+            if (!(cell_flags(target) & CELL_FLAG_PUSHABLE)) {
+                return;
+            }
+            int sx = (tx + dx + field->width) % field->width;
+            int sy = (ty + dy + field->height) % field->height;
+            if (cell_flags(field->grid[sx][sy].type) &
+                (CELL_FLAG_STOPS_PUSH | CELL_FLAG_BOUNCES_PUSH | CELL_FLAG_OCCUPIED)) {
+                return;  // Препятствие или отскок от дерева
+            }
+            crowd_add_claim(intent, tx, ty);
+            crowd_add_claim(intent, sx, sy);
+            break;
+        }
+
+        default:
+            return;
+    }
+
+    intent->type = cmd->type;
+    intent->target_x = tx;
+    intent->target_y = ty;
+
+    unsigned long long key = crowd_claim_key(crowd, id);
+    for (int i = 0; i < intent->claim_count; i++) {
+        crowd_claim(crowd, intent->claim_x[i], intent->claim_y[i], key);
+    }
+}
+
+// Фаза 2: выполнение намерения, если все клетки достались этому динозавру.
+// Пишутся только захваченные клетки и клетка самого динозавра, поэтому гонок нет
+static void crowd_apply(Crowd* crowd, int id) {
+    CrowdDino* dino = &crowd->dinos[id];
+    CrowdIntent* intent = &dino->intent;
+    Field* field = crowd->field;
+
+    if (intent->type == CMD_UNKNOWN) {
+        dino->blocked++;
+        return;
+    }
+
+    if (intent->fatal) {
+        field->grid[dino->x][dino->y].type = CELL_EMPTY;
+        dino->alive = 0;
+        dino->executed++;
+        return;
+    }
+
+    unsigned long long key = crowd_claim_key(crowd, id);
+    for (int i = 0; i < intent->claim_count; i++) {
+        if (atomic_load_explicit(&crowd->claims[intent->claim_x[i]][intent->claim_y[i]],
+                                 memory_order_relaxed) != key) {
+            dino->conflicts++;
+            dino->blocked++;
+            return;
+        }
+    }
+
+    Cell* target = &field->grid[intent->target_x][intent->target_y];
+    switch (intent->type) {
+        case CMD_MOVE:
+        case CMD_JUMP:
+            field->grid[dino->x][dino->y].type = CELL_EMPTY;
+            target->type = CELL_DINO;
+            dino->x = intent->target_x;
+            dino->y = intent->target_y;
+            break;
+        case CMD_PAINT:
+            field->grid[dino->x][dino->y].color = intent->color;
+            break;
+        case CMD_DIG: case CMD_MOUND: case CMD_GROW: case CMD_MAKE:
+            target->type = intent->create_type;
+            break;
+        case CMD_CUT:
+            target->type = CELL_EMPTY;
+            break;
+        case CMD_PUSH: {
+            Cell* destination = &field->grid[intent->claim_x[1]][intent->claim_y[1]];
+            CellType pushed = target->type;
+            target->type = CELL_EMPTY;
+            destination->type = (cell_flags(destination->type) & CELL_FLAG_FILLED_BY_PUSH) ? CELL_EMPTY : pushed;
+            break;
+        }
+        default:
+            break;
+    }
+    dino->executed++;
+}
+
+// Разбиение активных динозавров по вертикальным полосам поля.
+// Возвращает количество динозавров, которым еще есть что выполнять
+static int crowd_partition(Crowd* crowd) {
+    int counts[CROWD_MAX_THREADS + 1] = { 0 };
+    int bands = crowd->thread_count;
+    int width = crowd->field->width;
+    int active = 0;
+
+    for (int i = 0; i < crowd->dino_count; i++) {
+        CrowdDino* dino = &crowd->dinos[i];
+        if (dino->alive && dino->next_command < dino->stream->count) {
+            counts[dino->x * bands / width + 1]++;
+            active++;
+        }
+    }
+
+    crowd->band_start[0] = 0;
+    for (int band = 0; band < bands; band++) {
+        crowd->band_start[band + 1] = crowd->band_start[band] + counts[band + 1];
+        counts[band + 1] = crowd->band_start[band];
+    }
+
+    // Порядок внутри полосы - по номеру динозавра (детерминированно)
+    for (int i = 0; i < crowd->dino_count; i++) {
+        CrowdDino* dino = &crowd->dinos[i];
+        if (dino->alive && dino->next_command < dino->stream->count) {
+            crowd->band_order[counts[dino->x * bands / width + 1]++] = i;
+        }
+    }
+    return active;
+}
+
+static void crowd_plan_band(Crowd* crowd, int band) {
+    for (int i = crowd->band_start[band]; i < crowd->band_start[band + 1]; i++) {
+        crowd_plan(crowd, crowd->band_order[i]);
+    }
+}
+
+static void crowd_apply_band(Crowd* crowd, int band) {
+    for (int i = crowd->band_start[band]; i < crowd->band_start[band + 1]; i++) {
+        crowd_apply(crowd, crowd->band_order[i]);
+    }
+}
+
+// Рабочий поток: одна полоса поля на каждом такте
+static void* crowd_worker(void* arg) {
+    CrowdWorker* worker = arg;
+    CrowdPool* pool = worker->pool;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!pool->ready) {
+        pthread_cond_wait(&pool->ready_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (;;) {
+        pthread_barrier_wait(&pool->barrier);   // Начало такта
+        if (pool->stop) break;
+        crowd_plan_band(pool->crowd, worker->band);
+        pthread_barrier_wait(&pool->barrier);   // Все намерения и захваты готовы
+        crowd_apply_band(pool->crowd, worker->band);
+        pthread_barrier_wait(&pool->barrier);   // Такт завершен
+    }
+    return NULL;
+}
+
+// Выполнение тактов, пока у динозавров есть команды (не более max_ticks, 0 - без ограничения).
+// Возвращает количество выполненных тактов
+long crowd_run(Crowd* crowd, long max_ticks) {
+    int threads = crowd->thread_count;
+    CrowdPool pool;
+    pthread_t handles[CROWD_MAX_THREADS];
+    CrowdWorker workers[CROWD_MAX_THREADS];
+    long start_tick = crowd->tick;
+
+    if (crowd->dino_count == 0) {
+        return 0;
+    }
+
+    pool.crowd = crowd;
+    pool.stop = 0;
+    pool.ready = 0;
+    if (threads > 1) {
+        pthread_mutex_init(&pool.mutex, NULL);
+        pthread_cond_init(&pool.ready_cond, NULL);
+
+        int created = 1;
+        for (int t = 1; t < threads; t++) {
+            workers[t].pool = &pool;
+            workers[t].band = t;
+            if (pthread_create(&handles[t], NULL, crowd_worker, &workers[t]) != 0) {
+                printf("Warning: Cannot create crowd thread %d, using %d threads\n", t, created);
+                break;
+            }
+            created++;
+        }
+
+        // Полос столько же, сколько реально запущено потоков
+        threads = created;
+        crowd->thread_count = created;
+        if (threads > 1) {
+            pthread_barrier_init(&pool.barrier, NULL, threads);
+        }
+
+        pthread_mutex_lock(&pool.mutex);
+        pool.ready = 1;
+        pthread_cond_broadcast(&pool.ready_cond);
+        pthread_mutex_unlock(&pool.mutex);
+    }
+
+    while (max_ticks <= 0 || crowd->tick - start_tick < max_ticks) {
+        // Между тактами работает только этот поток
+        crowd->tick++;
+        if (crowd_partition(crowd) == 0) {
+            crowd->tick--;
+            break;
+        }
+
+        if (threads == 1) {
+            crowd_plan_band(crowd, 0);
+            crowd_apply_band(crowd, 0);
+        } else {
+            pthread_barrier_wait(&pool.barrier);
+            crowd_plan_band(crowd, 0);
+            pthread_barrier_wait(&pool.barrier);
+            crowd_apply_band(crowd, 0);
+            pthread_barrier_wait(&pool.barrier);
+        }
+    }
+
+    if (threads > 1) {
+        pool.stop = 1;
+        pthread_barrier_wait(&pool.barrier);
+        for (int t = 1; t < threads; t++) {
+            pthread_join(handles[t], NULL);
+        }
+        pthread_barrier_destroy(&pool.barrier);
+    }
+    if (pool.ready) {
+        pthread_cond_destroy(&pool.ready_cond);
+        pthread_mutex_destroy(&pool.mutex);
+    }
+
+    // Клетки менялись напрямую (без field_*) - хеш поля считается заново
+    field_rehash(crowd->field);
+    return crowd->tick - start_tick;
+}
+
+// Итоги выполнения толпы
+void crowd_print_summary(const Crowd* crowd, FILE* output) {
+    long executed = 0, blocked = 0, conflicts = 0;
+    int alive = 0;
+
+    for (int i = 0; i < crowd->dino_count; i++) {
+        const CrowdDino* dino = &crowd->dinos[i];
+        executed += dino->executed;
+        blocked += dino->blocked;
+        conflicts += dino->conflicts;
+        alive += dino->alive;
+
+        if (crowd->dino_count <= 20) {
+            fprintf(output, "Dino %d at (%d, %d)%s: %ld executed, %ld blocked, %ld conflicts lost\n",
+                    i, dino->x, dino->y, dino->alive ? "" : " [fell into a hole]",
+                    dino->executed, dino->blocked, dino->conflicts);
+        }
+    }
+
+    fprintf(output, "Crowd: %ld ticks on %d threads, %d of %d dinos alive, "
+            "%ld commands executed, %ld blocked, %ld conflicts\n",
+            crowd->tick, crowd->thread_count, alive, crowd->dino_count, executed, blocked, conflicts);
+}
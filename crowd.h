@@ -0,0 +1,70 @@
+#ifndef CROWD_H
+#define CROWD_H
+
+#include <stdatomic.h>
+#include "field.h"
+#include "parser.h"
+
+#define CROWD_MAX_DINOS (MAX_WIDTH * MAX_HEIGHT)
+#define CROWD_MAX_THREADS 64
+#define CROWD_MAX_STREAMS 256   // Различных файлов команд
+
+// Намерение динозавра на текущий такт (вычисляется по состоянию начала такта)
+typedef struct {
+    CommandType type;       // CMD_UNKNOWN - ничего не делать
+    int claim_count;        // Сколько клеток захватывает
+    int claim_x[2], claim_y[2];
+    int target_x, target_y; // Новая позиция / целевая клетка
+    int fatal;              // Попадание в яму
+    char color;             // Для PAINT
+    CellType create_type;   // Для DIG/MOUND/GROW/MAKE
+} CrowdIntent;
+
+// Поток команд (общий для динозавров с одним файлом)
+typedef struct {
+    char filename[MAX_FILENAME_LENGTH];
+    ParsedCommand* commands;
+    int count;
+} CrowdStream;
+
+// Динозавр толпы
+typedef struct {
+    int x, y;
+    int alive;
+    const CrowdStream* stream;
+    int next_command;
+    CrowdIntent intent;
+    long executed;          // Выполнено команд
+    long blocked;           // Команд без эффекта (препятствие или конфликт)
+    long conflicts;         // Проиграно конфликтов за клетку
+} CrowdDino;
+
+// Толпа динозавров на одном поле, шаги выполняются тактами
+typedef struct {
+    Field* field;
+    CrowdDino* dinos;
+    int dino_count;
+    int thread_count;
+    long tick;
+
+    CrowdStream streams[CROWD_MAX_STREAMS];
+    int stream_count;
+
+    // Захваты клеток на такт: (такт << 32) | (0xFFFFFFFF - номер динозавра),
+    // атомарный максимум оставляет динозавра с меньшим номером
+    _Atomic unsigned long long claims[MAX_WIDTH][MAX_HEIGHT];
+
+    // Разбиение динозавров по вертикальным полосам поля (по потокам)
+    int* band_order;
+    int band_start[CROWD_MAX_THREADS + 1];
+} Crowd;
+
+// Функции толпы
+Crowd* crowd_create(Field* field, int thread_count);
+void crowd_destroy(Crowd* crowd);
+int crowd_load(Crowd* crowd, const char* filename);
+int crowd_add_dino(Crowd* crowd, int x, int y, const char* script_filename);
+long crowd_run(Crowd* crowd, long max_ticks);
+void crowd_print_summary(const Crowd* crowd, FILE* output);
+
+#endif
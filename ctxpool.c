@@ -0,0 +1,56 @@
+#include "ctxpool.h"
+
+// Создание пустого пула
+ContextPool* context_pool_create(void) {
+    ContextPool* pool = calloc(1, sizeof(ContextPool));
+    if (pool == NULL) {
+        printf("Error: Cannot allocate context pool\n");
+    }
+    return pool;
+}
+
+static void context_pool_free_context(InterpreterContext* context) {
+    interpreter_free(context);
+    free(context);
+}
+
+// Освобождение пула и свободных контекстов (выданные освобождает владелец)
+void context_pool_destroy(ContextPool* pool) {
+    if (pool == NULL) return;
+
+    for (int i = 0; i < pool->idle_count; i++) {
+        context_pool_free_context(pool->idle[i]);
+    }
+    free(pool);
+}
+
+// Контекст в начальном состоянии: свободный из пула (сброс при выдаче) или новый
+InterpreterContext* context_pool_acquire(ContextPool* pool) {
+    if (pool->idle_count > 0) {
+        InterpreterContext* context = pool->idle[--pool->idle_count];
+        interpreter_reset(context);
+        pool->reused++;
+        return context;
+    }
+
+    InterpreterContext* context = malloc(sizeof(InterpreterContext));
+    if (context == NULL) {
+        printf("Error: Cannot allocate interpreter context\n");
+        return NULL;
+    }
+    interpreter_init(context);
+    pool->created++;
+    return context;
+}
+
+// Возврат контекста в пул. Кэш скриптов принадлежит вызывающему и отвязывается
+void context_pool_release(ContextPool* pool, InterpreterContext* context) {
+    if (context == NULL) return;
+
+    context->script_cache = NULL;
+    if (pool->idle_count < CONTEXT_POOL_MAX_IDLE) {
+        pool->idle[pool->idle_count++] = context;
+    } else {
+        context_pool_free_context(context);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef CTXPOOL_H
+#define CTXPOOL_H
+
+#include "interpreter.h"
+
+#define CONTEXT_POOL_MAX_IDLE 64    // Больше свободных контекстов не хранится
+
+// Пул контекстов интерпретатора для коротких заданий: контекст не создается
+// заново, а сбрасывается в пределах того, что использовало прошлое задание
+typedef struct {
+    InterpreterContext* idle[CONTEXT_POOL_MAX_IDLE];
+    int idle_count;
+    long created;               // Создано контекстов
+    long reused;                // Выдано повторно
+} ContextPool;
+
+// Функции пула контекстов
+ContextPool* context_pool_create(void);
+void context_pool_destroy(ContextPool* pool);
+InterpreterContext* context_pool_acquire(ContextPool* pool);
+void context_pool_release(ContextPool* pool, InterpreterContext* context);
+
+#endif
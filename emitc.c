@@ -0,0 +1,331 @@
+#include "emitc.h"
+#include "utils.h"
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+
+// Разобранный файл скрипта (без комментариев и пустых строк)
+typedef struct {
+    ParsedCommand* commands;
+    int* lines;
+    int count;
+} EmitScript;
+
+// Состояние трансляции
+typedef struct {
+    FILE* output;
+    int function_count;     // Функций для встроенных файлов EXEC
+} EmitState;
+
+// Вывод строкового литерала C
+static void emitc_string(FILE* output, const char* text) {
+    fputc('"', output);
+    for (; *text != '\0'; text++) {
+        unsigned char c = (unsigned char)*text;
+        if (c == '"' || c == '\\') {
+            fprintf(output, "\\%c", c);
+        } else if (c < 32 || c >= 127) {
+            fprintf(output, "\\%03o", c);
+        } else {
+            fputc(c, output);
+        }
+    }
+    fputc('"', output);
+}
+
+static void emitc_free_script(EmitScript* script) {
+    free(script->commands);
+    free(script->lines);
+}
+
+// Чтение и разбор файла. Возвращает -1, если файл не открывается, -2 при ошибке разбора
+static int emitc_load_script(const char* filename, EmitScript* script) {
+    script->commands = NULL;
+    script->lines = NULL;
+    script->count = 0;
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int capacity = 0;
+    while (read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+
+        ParsedCommand cmd;
+        memset(&cmd, 0, sizeof(cmd));  // Неиспользуемые поля попадают в код нулями
+        if (parse_line(line, &cmd) != 0) {
+            printf("Error: Cannot translate %s line %d: %s\n", filename, line_number, line);
+            fclose(file);
+            emitc_free_script(script);
+            return -2;
+        }
+        if (cmd.type == CMD_COMMENT) {
+            continue;
+        }
+
+        if (script->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ParsedCommand* commands = realloc(script->commands, capacity * sizeof(ParsedCommand));
+            int* lines = realloc(script->lines, capacity * sizeof(int));
+            if (commands != NULL) script->commands = commands;
+            if (lines != NULL) script->lines = lines;
+            if (commands == NULL || lines == NULL) {
+                printf("Error: Cannot allocate memory for script '%s'\n", filename);
+                fclose(file);
+                emitc_free_script(script);
+                return -2;
+            }
+        }
+        script->commands[script->count] = cmd;
+        script->lines[script->count] = line_number;
+        script->count++;
+    }
+
+    fclose(file);
+    return 0;
+}
+
+// Вызов функции field_* для команды с постоянным направлением
+static void emitc_field_call(FILE* output, const ParsedCommand* cmd, int dx, int dy) {
+    switch (cmd->type) {
+        case CMD_MOVE:
+            fprintf(output, "field_move_dino(&context->field, %d, %d)", dx, dy);
+            break;
+        case CMD_JUMP:
+            fprintf(output, "field_jump_dino(&context->field, %d, %d, %d)", dx, dy, cmd->n);
+            break;
+        case CMD_CUT:
+            fprintf(output, "field_cut_tree(&context->field, %d, %d)", dx, dy);
+            break;
+        case CMD_PUSH:
+            fprintf(output, "field_push_stone(&context->field, %d, %d)", dx, dy);
+            break;
+        default:
+            fprintf(output, "field_create_object(&context->field, %d, %d, %s)", dx, dy,
+                    cmd->type == CMD_DIG ? "CELL_HOLE" :
+                    cmd->type == CMD_MOUND ? "CELL_MOUNTAIN" :
+                    cmd->type == CMD_GROW ? "CELL_TREE" : "CELL_STONE");
+            break;
+    }
+}
+
+// Команда, которую выполняет интерпретатор (разбор уже сделан при трансляции)
+static void emitc_interpreted(FILE* output, const ParsedCommand* cmd, int line_number) {
+    static const char* condition_names[] = { "IF_CELL", "IF_COUNT", "IF_NEAREST" };
+
+    fprintf(output, "    {\n        static ParsedCommand command = { .type = CMD_%s, .direction = ",
+            command_type_name(cmd->type));
+    emitc_string(output, cmd->direction);
+    fprintf(output, ",\n            .x = %d, .y = %d, .n = %d, .x2 = %d, .y2 = %d, .color = %d, .replacement = %d,\n",
+            cmd->x, cmd->y, cmd->n, cmd->x2, cmd->y2, cmd->color, cmd->replacement);
+    fprintf(output, "            .condition = %s, .compare = %d, .filename = ",
+            condition_names[cmd->condition], cmd->compare);
+    emitc_string(output, cmd->filename);
+    fprintf(output, ",\n            .then_command = ");
+    emitc_string(output, cmd->then_command);
+    fprintf(output, " };\n        result = interpreter_execute_command(context, &command, %d);\n    }\n", line_number);
+}
+
+// Одна команда скрипта. child - номер функции встроенного файла для EXEC (-1 - не встроен)
+static void emitc_command(FILE* output, const ParsedCommand* cmd, int line_number, int child) {
+    char echo[MAX_LINE_LENGTH + 16];
+    int dx = 0, dy = 0;
+    int direction_ok = get_direction_offset(parse_direction(cmd->direction), &dx, &dy) == 0;
+
+    switch (cmd->type) {
+        case CMD_MOVE:
+        case CMD_JUMP:
+        case CMD_DIG:
+        case CMD_MOUND:
+        case CMD_GROW:
+        case CMD_MAKE:
+        case CMD_CUT:
+        case CMD_PUSH:
+            if (!direction_ok || (cmd->type == CMD_JUMP && cmd->n <= 0)) {
+                break;  // Ошибку выдаст интерпретатор
+            }
+            if (cmd->type == CMD_JUMP) {
+                snprintf(echo, sizeof(echo), "JUMP %s %d", cmd->direction, cmd->n);
+            } else {
+                snprintf(echo, sizeof(echo), "%s %s", command_type_name(cmd->type), cmd->direction);
+            }
+            fprintf(output, "    result = interpreter_begin_command(context, CMD_%s, %d, ",
+                    command_type_name(cmd->type), line_number);
+            emitc_string(output, echo);
+            fprintf(output, ");\n    if (result == 0 && (result = interpreter_require_dino(context, CMD_%s)) == 0) {\n",
+                    command_type_name(cmd->type));
+            fprintf(output, "        result = interpreter_check_field_result(context, CMD_%s, ",
+                    command_type_name(cmd->type));
+            emitc_field_call(output, cmd, dx, dy);
+            fprintf(output, ", %d, %d);\n", dx, dy);
+            fprintf(output, "        if (!context->error_occurred) {\n"
+                            "            interpreter_end_command(context);\n"
+                            "        }\n    }\n");
+            return;
+
+        case CMD_PAINT:
+            if (cmd->color < 'a' || cmd->color > 'z') {
+                break;
+            }
+            fprintf(output, "    result = interpreter_begin_command(context, CMD_PAINT, %d, \"PAINT %c\");\n",
+                    line_number, cmd->color);
+            fprintf(output, "    if (result == 0 && (result = interpreter_require_dino(context, CMD_PAINT)) == 0) {\n"
+                            "        field_paint_cell(&context->field, '%c');\n"
+                            "        interpreter_end_command(context);\n    }\n", cmd->color);
+            return;
+
+        case CMD_EXEC:
+            if (child < 0) {
+                break;
+            }
+            snprintf(echo, sizeof(echo), "EXEC %s", cmd->filename);
+            fprintf(output, "    result = interpreter_begin_command(context, CMD_EXEC, %d, ", line_number);
+            emitc_string(output, echo);
+            fprintf(output, ");\n    if (result == 0) {\n        result = script_file_%d(context);\n", child);
+            fprintf(output, "        if (result != 0) {\n            printf(\"EXEC failed for file: %%s\\n\", ");
+            emitc_string(output, cmd->filename);
+            fprintf(output, ");\n        }\n        interpreter_end_command(context);\n    }\n");
+            return;
+
+        default:
+            break;
+    }
+
+    // SIZE, START, LOAD, UNDO, IF, GOTO, TICK, FILL, CLEAR, REPLACE, STAMP и команды с ошибкой в аргументах
+    emitc_interpreted(output, cmd, line_number);
+}
+
+// Трансляция файла и (рекурсивно) встраиваемых им файлов EXEC.
+// Файл глубины 0 становится точкой входа, остальные - статическими функциями.
+// Возвращает номер функции, -1 если файл не открывается, -2 при ошибке
+static int emitc_file(EmitState* state, const char* filename, int depth) {
+    EmitScript script;
+    int result = emitc_load_script(filename, &script);
+    if (result != 0) {
+        return result;
+    }
+
+    // Вложенные файлы выводятся до функции, которая их вызывает
+    int* children = malloc((script.count > 0 ? script.count : 1) * sizeof(int));
+    if (children == NULL) {
+        emitc_free_script(&script);
+        return -2;
+    }
+    for (int i = 0; i < script.count; i++) {
+        children[i] = -1;
+        if (script.commands[i].type == CMD_EXEC && depth < EMITC_MAX_DEPTH) {
+            children[i] = emitc_file(state, script.commands[i].filename, depth + 1);
+            if (children[i] == -2) {
+                free(children);
+                emitc_free_script(&script);
+                return -2;
+            }
+        }
+    }
+
+    FILE* output = state->output;
+    int id = state->function_count++;
+    fprintf(output, "// %s\n", filename);
+    if (depth == 0) {
+        fprintf(output, "int dino_script_run(InterpreterContext* context) {\n    int result = 0;\n\n");
+    } else {
+        fprintf(output, "static int script_file_%d(InterpreterContext* context) {\n", id);
+        fprintf(output, "    char saved_filename[256];\n    int result = interpreter_enter_file(context, ");
+        emitc_string(output, filename);
+        fprintf(output, ", saved_filename);\n    if (result != 0) {\n        return result;\n    }\n\n");
+    }
+
+    for (int i = 0; i < script.count; i++) {
+        const ParsedCommand* cmd = &script.commands[i];
+        int line_number = script.lines[i];
+        const char* leave = (depth == 0) ? "return 0" : "goto finish";
+
+        fprintf(output, "    // line %d: %s\n", line_number, command_type_name(cmd->type));
+        fprintf(output, "    if (context->error_occurred) {\n        %s;\n    }\n", leave);
+        emitc_command(output, cmd, line_number, children[i]);
+        fprintf(output, "    if (result < 0 && context->error_occurred) {\n");
+        if (depth == 0) {
+            fprintf(output, "        printf(\"Fatal error at line %d: %%s\\n\", interpreter_get_error_message(context));\n",
+                    line_number);
+        } else {
+            fprintf(output, "        printf(\"Fatal error at line %d in %%s: %%s\\n\", ", line_number);
+            emitc_string(output, filename);
+            fprintf(output, ", interpreter_get_error_message(context));\n");
+        }
+        fprintf(output, "        %s;\n    }\n\n", leave);
+    }
+
+    if (depth == 0) {
+        fprintf(output, "    return 0;\n}\n\n");
+    } else {
+        fprintf(output, "    goto finish;\nfinish:\n    interpreter_leave_file(context, ");
+        emitc_string(output, filename);
+        fprintf(output, ", saved_filename);\n    return result;\n}\n\n");
+    }
+
+    free(children);
+    emitc_free_script(&script);
+    return id;
+}
+
+// Трансляция скрипта со встроенными файлами EXEC в единицу трансляции C
+int emitc_translate(const char* script_filename, FILE* output) {
+    EmitState state = { output, 0 };
+
+    fprintf(output, "// Generated by dino --emit-c from ");
+    emitc_string(output, script_filename);
+    fprintf(output, "\n//\n"
+                    "// Build (dino itself must be linked with -rdynamic):\n"
+                    "//   gcc -O2 -shared -fPIC -I<dino sources> script.c -o script.so\n"
+                    "// Run:\n"
+                    "//   dino script.so output.txt --native [options]\n\n"
+                    "#include \"interpreter.h\"\n\n"
+                    "const unsigned long dino_script_context_size = sizeof(InterpreterContext);\n\n");
+
+    int result = emitc_file(&state, script_filename, 0);
+    if (result == -1) {
+        printf("Error: Cannot open input file '%s'\n", script_filename);
+    }
+    return result < 0 ? -1 : 0;
+}
+
+// Загрузка собранного скрипта и выполнение его точки входа
+int emitc_run_native(InterpreterContext* context, const char* library_filename) {
+#ifdef _WIN32
+    (void)context;
+    printf("Error: --native is not supported on this platform ('%s')\n", library_filename);
+    return -1;
+#else
+    // Путь без '/' dlopen ищет в системных каталогах
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", strchr(library_filename, '/') ? "" : "./", library_filename);
+
+    void* library = dlopen(path, RTLD_NOW);
+    if (library == NULL) {
+        printf("Error: Cannot load compiled script: %s\n", dlerror());
+        return -1;
+    }
+
+    const unsigned long* context_size = dlsym(library, EMITC_CONTEXT_SIZE_SYMBOL);
+    int (*entry)(InterpreterContext*) = (int (*)(InterpreterContext*))dlsym(library, EMITC_ENTRY_POINT);
+    if (context_size == NULL || entry == NULL) {
+        printf("Error: '%s' is not a compiled dino script\n", library_filename);
+        dlclose(library);
+        return -1;
+    }
+    if (*context_size != sizeof(InterpreterContext)) {
+        printf("Error: '%s' was built for a different interpreter version, regenerate it with --emit-c\n",
+               library_filename);
+        dlclose(library);
+        return -1;
+    }
+
+    entry(context);
+    dlclose(library);
+    return 0;
+#endif
+}
@@ -0,0 +1,17 @@
+#ifndef EMITC_H
+#define EMITC_H
+
+#include "interpreter.h"
+
+// Точка входа скомпилированного скрипта: int dino_script_run(InterpreterContext* context)
+#define EMITC_ENTRY_POINT "dino_script_run"
+// Размер InterpreterContext, с которым собран скрипт (проверяется при загрузке)
+#define EMITC_CONTEXT_SIZE_SYMBOL "dino_script_context_size"
+
+#define EMITC_MAX_DEPTH MAX_EXEC_DEPTH  // Как у EXEC в интерпретаторе: глубже файлы не встраиваются
+
+// Функции трансляции скриптов в C (--emit-c) и запуска собранного кода (--native)
+int emitc_translate(const char* script_filename, FILE* output);
+int emitc_run_native(InterpreterContext* context, const char* library_filename);
+
+#endif
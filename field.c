@@ -1,13 +1,32 @@
 #include "field.h"
+#include "heatmap.h"
+#include "counts.h"
 #include "utils.h"
 #include <stdio.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Свойства типов клеток: по этой таблице работают команды поля, GOTO, толпа и --solve
+const CellProperties cell_properties[256] = {
+    [CELL_EMPTY]    = { CELL_FLAG_OBJECT | CELL_FLAG_BUILDABLE, "empty" },
+    [CELL_DINO]     = { CELL_FLAG_OCCUPIED, "dino" },
+    [CELL_HOLE]     = { CELL_FLAG_OBJECT | CELL_FLAG_FATAL | CELL_FLAG_FILLED_BY_PUSH, "hole" },
+    [CELL_MOUNTAIN] = { CELL_FLAG_OBJECT | CELL_FLAG_BLOCKS | CELL_FLAG_STOPS_PUSH, "mountain" },
+    [CELL_TREE]     = { CELL_FLAG_OBJECT | CELL_FLAG_BLOCKS | CELL_FLAG_CUTTABLE | CELL_FLAG_BOUNCES_PUSH, "tree" },
+    [CELL_STONE]    = { CELL_FLAG_OBJECT | CELL_FLAG_BLOCKS | CELL_FLAG_PUSHABLE | CELL_FLAG_STOPS_PUSH, "stone" },
+};
+
 // Инициализация поля начальными значениями
 void field_init(Field* field) {
     field->width = 0;
     field->height = 0;
     field->dino_x = -1;
     field->dino_y = -1;
+    field->heatmap = NULL;
+    field->counts = NULL;
+    field->hash = 0;
     
     // Инициализация всех клеток как пустых
     for (int i = 0; i < MAX_WIDTH; i++) {
@@ -18,6 +37,88 @@ void field_init(Field* field) {
     }
 }
 
+// Сброс поля к пустому состоянию: очищается только использованная область
+// (клетки за пределами размеров поля всегда пустые). Счетчики активности
+// и индексы символов сохраняются
+void field_reset(Field* field) {
+    for (int i = 0; i < field->width; i++) {
+        for (int j = 0; j < field->height; j++) {
+            field->grid[i][j].type = CELL_EMPTY;
+            field->grid[i][j].color = '\0';
+        }
+    }
+    field->width = 0;
+    field->height = 0;
+    field->dino_x = -1;
+    field->dino_y = -1;
+    field->hash = 0;
+    counts_invalidate(field->counts);
+}
+
+// Учет активности клетки (одна проверка указателя, если счетчики выключены)
+static inline void field_heat_visit(Field* field, int x, int y) {
+    if (field->heatmap != NULL) field->heatmap->visits[x][y]++;
+}
+
+static inline void field_heat_failed_move(Field* field, int x, int y) {
+    if (field->heatmap != NULL) field->heatmap->failed_moves[x][y]++;
+}
+
+static inline void field_heat_mutation(Field* field, int x, int y) {
+    if (field->heatmap != NULL) field->heatmap->mutations[x][y]++;
+}
+
+// Ключ Зобриста символа в клетке (перемешивание splitmix64 вместо таблицы ключей).
+// Пустая клетка без цвета дает 0, поэтому хеш пустого поля любого размера - 0
+static inline uint64_t field_zobrist_key(int x, int y, char symbol) {
+    if (symbol == CELL_EMPTY || symbol == '\0') {
+        return 0;
+    }
+    uint64_t z = (((uint64_t)(x * MAX_HEIGHT + y) << 8) | (unsigned char)symbol) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Запись типа и цвета клетки с обновлением хеша и индексов IF COUNT/NEAREST
+static inline void field_set_type(Field* field, int x, int y, CellType type) {
+    Cell* cell = &field->grid[x][y];
+    if (field->counts != NULL) counts_update(field->counts, x, y, (char)cell->type, (char)type);
+    field->hash ^= field_zobrist_key(x, y, (char)cell->type) ^ field_zobrist_key(x, y, (char)type);
+    cell->type = type;
+}
+
+static inline void field_set_color(Field* field, int x, int y, char color) {
+    Cell* cell = &field->grid[x][y];
+    if (field->counts != NULL) counts_update(field->counts, x, y, cell->color, color);
+    field->hash ^= field_zobrist_key(x, y, cell->color) ^ field_zobrist_key(x, y, color);
+    cell->color = color;
+}
+
+// Запись клетки целиком (применение сохраненных изменений, --memo-exec)
+void field_set_cell(Field* field, int x, int y, Cell cell) {
+    field_set_type(field, x, y, cell.type);
+    field_set_color(field, x, y, cell.color);
+}
+
+// Хеш поля, посчитанный заново по всем клеткам. Положение динозавра входит
+// в хеш через тип его клетки
+uint64_t field_compute_hash(const Field* field) {
+    uint64_t hash = 0;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            hash ^= field_zobrist_key(x, y, (char)field->grid[x][y].type) ^
+                    field_zobrist_key(x, y, field->grid[x][y].color);
+        }
+    }
+    return hash;
+}
+
+// Пересчет хеша после изменения клеток в обход field_* (загрузка, толпа)
+void field_rehash(Field* field) {
+    field->hash = field_compute_hash(field);
+}
+
 // Получение текстового описания ошибки по коду
 const char* field_get_error_message(int error_code) {
     switch (error_code) {
@@ -31,6 +132,8 @@ const char* field_get_error_message(int error_code) {
         case -8: return "No stone to push";
         case -9: return "Stone push blocked";
         case -10: return "Stone hit tree - bounced back";
+        case -11: return "No path to target cell";
+        case -12: return "Invalid symbol for region command";
         default: return "Unknown error";
     }
 }
@@ -70,7 +173,7 @@ int field_set_dino_position(Field* field, int x, int y) {
     if (field->dino_x != -1 && field->dino_y != -1) {
         Cell* old_cell = field_get_cell(field, field->dino_x, field->dino_y);
         if (old_cell->type == CELL_DINO) {
-            old_cell->type = CELL_EMPTY;
+            field_set_type(field, field->dino_x, field->dino_y, CELL_EMPTY);
         }
     }
     
@@ -78,8 +181,8 @@ int field_set_dino_position(Field* field, int x, int y) {
     field->dino_x = x;
     field->dino_y = y;
     
-    Cell* new_cell = field_get_cell(field, x, y);
-    new_cell->type = CELL_DINO;
+    field_set_type(field, x, y, CELL_DINO);
+    field_heat_visit(field, x, y);
     
     printf("Dino placed at position (%d, %d)\n", x, y);
     return 0;
@@ -97,25 +200,26 @@ int field_move_dino(Field* field, int dx, int dy) {
     int new_y = (field->dino_y + dy + field->height) % field->height;
     
     Cell* target_cell = field_get_cell(field, new_x, new_y);
+    uint16_t flags = cell_flags(target_cell->type);
     
     // Проверка препятствий
-    if (target_cell->type == CELL_HOLE) {
-        printf("Fatal Error: Dino fell into a hole at cell (%d, %d)!\n", new_x, new_y);
-        return -4;
-    }
-    if (target_cell->type == CELL_MOUNTAIN || 
-        target_cell->type == CELL_TREE || 
-        target_cell->type == CELL_STONE) {
+    if (flags & (CELL_FLAG_FATAL | CELL_FLAG_BLOCKS)) {
+        field_heat_failed_move(field, new_x, new_y);
+        if (flags & CELL_FLAG_FATAL) {
+            printf("Fatal Error: Dino fell into a %s at cell (%d, %d)!\n",
+                   cell_properties[(unsigned char)target_cell->type].name, new_x, new_y);
+            return -4;
+        }
         return -3;  // Возврат кода ошибки (interpreter.c)
     }
     
     // Перемещение динозавра
-    Cell* current_cell = field_get_cell(field, field->dino_x, field->dino_y);
-    current_cell->type = CELL_EMPTY;
+    field_set_type(field, field->dino_x, field->dino_y, CELL_EMPTY);
     
     field->dino_x = new_x;
     field->dino_y = new_y;
-    target_cell->type = CELL_DINO;
+    field_set_type(field, new_x, new_y, CELL_DINO);
+    field_heat_visit(field, new_x, new_y);
     
     printf("Dino moved to (%d, %d)\n", new_x, new_y);
     return 0;
@@ -128,9 +232,9 @@ void field_paint_cell(Field* field, char color) {
         return;
     }
     
-    Cell* cell = field_get_cell(field, field->dino_x, field->dino_y);
     if (color >= 'a' && color <= 'z') {
-        cell->color = color;
+        field_set_color(field, field->dino_x, field->dino_y, color);
+        field_heat_mutation(field, field->dino_x, field->dino_y);
         printf("Cell (%d, %d) painted with color '%c'\n", field->dino_x, field->dino_y, color);
     } else {
         printf("Error: Invalid color '%c'. Valid colors are lowercase letters a-z\n", color);
@@ -149,32 +253,27 @@ int field_create_object(Field* field, int dx, int dy, CellType type) {
     int target_y = (field->dino_y + dy + field->height) % field->height;
     
     Cell* target_cell = field_get_cell(field, target_x, target_y);
+    uint16_t flags = cell_flags(target_cell->type);
     
     // Можно создавать объекты только на пустых клетках
-    if (target_cell->type != CELL_EMPTY) {
+    if (!(flags & CELL_FLAG_BUILDABLE)) {
         return -6;
     }
     
     // Возведение горы на яме
-    if (type == CELL_MOUNTAIN && target_cell->type == CELL_HOLE) {
-    target_cell->type = CELL_EMPTY;
+    if (type == CELL_MOUNTAIN && (flags & CELL_FLAG_FILLED_BY_PUSH)) {
+    field_set_type(field, target_x, target_y, CELL_EMPTY);
     
     printf("Hole at cell (%d, %d) filled with mountain\n", target_x, target_y);
     return 0;
 }
     
     // Создание объекта
-    target_cell->type = type;
+    field_set_type(field, target_x, target_y, type);
+    field_heat_mutation(field, target_x, target_y);
     
-    const char* obj_name = "";
-    switch (type) {
-        case CELL_HOLE: obj_name = "hole"; break;
-        case CELL_MOUNTAIN: obj_name = "mountain"; break;
-        case CELL_TREE: obj_name = "tree"; break;
-        case CELL_STONE: obj_name = "stone"; break;
-        default: obj_name = "object"; break;
-    }
-    printf("Created %s at cell (%d, %d)\n", obj_name, target_x, target_y);
+    const char* obj_name = cell_properties[(unsigned char)type].name;
+    printf("Created %s at cell (%d, %d)\n", obj_name != NULL ? obj_name : "object", target_x, target_y);
     
     return 0;
 }
@@ -192,11 +291,12 @@ int field_cut_tree(Field* field, int dx, int dy) {
     Cell* target_cell = field_get_cell(field, target_x, target_y);
     
     // Проверка, что в клетке есть дерево
-    if (target_cell->type != CELL_TREE) {
+    if (!(cell_flags(target_cell->type) & CELL_FLAG_CUTTABLE)) {
         return -7;  // Нет дерева для срубания
     }
     
-    target_cell->type = CELL_EMPTY;
+    field_set_type(field, target_x, target_y, CELL_EMPTY);
+    field_heat_mutation(field, target_x, target_y);
     
     printf("Tree cut at cell (%d, %d)\n", target_x, target_y);
     return 0;
@@ -216,7 +316,8 @@ int field_push_stone(Field* field, int dx, int dy) {
     Cell* stone_cell = field_get_cell(field, stone_x, stone_y);
     
     // Проверка, что в клетке есть камень
-    if (stone_cell->type != CELL_STONE) {
+    CellType stone_type = stone_cell->type;
+    if (!(cell_flags(stone_type) & CELL_FLAG_PUSHABLE)) {
         return -8;  // Нет камня для пинания
     }
     
@@ -229,23 +330,26 @@ int field_push_stone(Field* field, int dx, int dy) {
     int new_y = (stone_y + push_dy + field->height) % field->height;
     
     Cell* target_cell = field_get_cell(field, new_x, new_y);
+    uint16_t flags = cell_flags(target_cell->type);
     
     // Проверка направления движения камня
-    if (target_cell->type == CELL_TREE) {
+    if (flags & CELL_FLAG_BOUNCES_PUSH) {
         return -10;  // Камень отскочил от дерева
     }
-    if (target_cell->type == CELL_MOUNTAIN || target_cell->type == CELL_STONE) {
+    if (flags & CELL_FLAG_STOPS_PUSH) {
         return -9;  // Препятствие
     }
     
-    stone_cell->type = CELL_EMPTY;
+    field_set_type(field, stone_x, stone_y, CELL_EMPTY);
+    field_heat_mutation(field, stone_x, stone_y);
+    field_heat_mutation(field, new_x, new_y);
     
     // Камень попадает в яму
-    if (target_cell->type == CELL_HOLE) {
-    target_cell->type = CELL_EMPTY;
+    if (flags & CELL_FLAG_FILLED_BY_PUSH) {
+    field_set_type(field, new_x, new_y, CELL_EMPTY);
     printf("Stone filled hole at cell (%d, %d)\n", new_x, new_y);
     } else {
-    target_cell->type = CELL_STONE;
+    field_set_type(field, new_x, new_y, stone_type);
     printf("Stone pushed to (%d, %d)\n", new_x, new_y);
     }
     
@@ -274,21 +378,22 @@ int field_jump_dino(Field* field, int dx, int dy, int distance) {
         int check_y = (current_y + dy * i + field->height) % field->height;
         
         Cell* check_cell = field_get_cell(field, check_x, check_y);
+        uint16_t flags = cell_flags(check_cell->type);
         
         // Остановка перед горой, деревом или камнем
-        if (check_cell->type == CELL_MOUNTAIN || 
-            check_cell->type == CELL_TREE || 
-            check_cell->type == CELL_STONE) {
+        if (flags & CELL_FLAG_BLOCKS) {
             blocked_at_x = check_x;
             blocked_at_y = check_y;
+            field_heat_failed_move(field, check_x, check_y);
             distance = i - 1;  // Прыжок ровно до препятствия
             break;
         }
         
         // Приземление в яму
-        if (i == distance && check_cell->type == CELL_HOLE) {
-            printf("Fatal Error: Dino landed in a hole at cell (%d, %d)!\n", 
-                   check_x, check_y);
+        if (i == distance && (flags & CELL_FLAG_FATAL)) {
+            field_heat_failed_move(field, check_x, check_y);
+            printf("Fatal Error: Dino landed in a %s at cell (%d, %d)!\n", 
+                   cell_properties[(unsigned char)check_cell->type].name, check_x, check_y);
             return -4;
         }
     }
@@ -301,13 +406,11 @@ int field_jump_dino(Field* field, int dx, int dy, int distance) {
     int new_x = (current_x + dx * distance + field->width) % field->width;
     int new_y = (current_y + dy * distance + field->height) % field->height;
     
-    Cell* current_cell = field_get_cell(field, current_x, current_y);
-    Cell* target_cell = field_get_cell(field, new_x, new_y);
-    
-    current_cell->type = CELL_EMPTY;
+    field_set_type(field, current_x, current_y, CELL_EMPTY);
     field->dino_x = new_x;
     field->dino_y = new_y;
-    target_cell->type = CELL_DINO;
+    field_set_type(field, new_x, new_y, CELL_DINO);
+    field_heat_visit(field, new_x, new_y);
     
     printf("Dino jumped %d cells to position (%d, %d)\n", distance, new_x, new_y);
     
@@ -352,35 +455,107 @@ Cell* field_get_cell(Field* field, int x, int y) {
     return &field->grid[x][y];
 }
 
-// Вывод поля в файл
-void field_print(Field* field, FILE* output) {
-    for (int y = 0; y < field->height; y++) {
-        for (int x = 0; x < field->width; x++) {
-            Cell* cell = &field->grid[x][y];
-            if (cell->color != '\0') {
-                fprintf(output, "%c", cell->color);
-            } else {
-                fprintf(output, "%c", (char)cell->type);
-            }
+// Символ, которым клетка выводится в файл (цвет имеет приоритет над типом)
+static char field_cell_symbol(const Cell* cell) {
+    return (cell->color != '\0') ? cell->color : (char)cell->type;
+}
+
+// Выбор символов для столбца клеток: цвет, если задан, иначе тип клетки.
+// Клетка занимает 8 байт: тип (int) и цвет (char) + выравнивание,
+// поэтому векторные версии берут младший байт каждого 32-битного слова.
+#if defined(__SSE2__)
+// Две клетки в регистре -> символы в 32-битных словах 0 и 1
+static inline __m128i field_select_pair_sse2(__m128i cells) {
+    const __m128i low_byte = _mm_set1_epi32(0xFF);
+    __m128i type = _mm_and_si128(cells, low_byte);
+    __m128i color = _mm_and_si128(_mm_srli_si128(cells, 4), low_byte);
+    __m128i no_color = _mm_cmpeq_epi32(color, _mm_setzero_si128());
+    __m128i symbol = _mm_or_si128(_mm_and_si128(no_color, type), _mm_andnot_si128(no_color, color));
+    return _mm_shuffle_epi32(symbol, _MM_SHUFFLE(3, 1, 2, 0));
+}
+#endif
+
+#if defined(__AVX2__)
+// Четыре клетки в регистре -> символы в 32-битных словах 0..3 младшей половины
+static inline __m128i field_select_quad_avx2(__m256i cells) {
+    const __m256i low_byte = _mm256_set1_epi32(0xFF);
+    const __m256i even_lanes = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    __m256i type = _mm256_and_si256(cells, low_byte);
+    __m256i color = _mm256_and_si256(_mm256_srli_si256(cells, 4), low_byte);
+    __m256i no_color = _mm256_cmpeq_epi32(color, _mm256_setzero_si256());
+    __m256i symbol = _mm256_blendv_epi8(color, type, no_color);
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(symbol, even_lanes));
+}
+#endif
+
+static void field_render_column(const Cell* column, int height, char* out) {
+    int y = 0;
+    
+    if (sizeof(Cell) == 8) {
+#if defined(__AVX2__)
+        for (; y + 8 <= height; y += 8) {
+            const __m256i* src = (const __m256i*)(column + y);
+            __m128i first = field_select_quad_avx2(_mm256_loadu_si256(src));
+            __m128i second = field_select_quad_avx2(_mm256_loadu_si256(src + 1));
+            __m128i packed = _mm_packs_epi32(first, second);
+            _mm_storel_epi64((__m128i*)(out + y), _mm_packus_epi16(packed, packed));
+        }
+#elif defined(__SSE2__)
+        for (; y + 8 <= height; y += 8) {
+            const __m128i* src = (const __m128i*)(column + y);
+            __m128i first = _mm_unpacklo_epi64(field_select_pair_sse2(_mm_loadu_si128(src)),
+                                               field_select_pair_sse2(_mm_loadu_si128(src + 1)));
+            __m128i second = _mm_unpacklo_epi64(field_select_pair_sse2(_mm_loadu_si128(src + 2)),
+                                                field_select_pair_sse2(_mm_loadu_si128(src + 3)));
+            __m128i packed = _mm_packs_epi32(first, second);
+            _mm_storel_epi64((__m128i*)(out + y), _mm_packus_epi16(packed, packed));
+        }
+#endif
+    }
+    
+    // Скалярный остаток (и вариант без SIMD)
+    for (; y < height; y++) {
+        out[y] = field_cell_symbol(&column[y]);
+    }
+}
+
+// Отрисовка всего поля в буфер: строки по width символов, каждая с '\n'.
+// Буфер должен вмещать FIELD_RENDER_BUFFER_SIZE байт. Возвращает длину текста.
+int field_render(const Field* field, char* buffer) {
+    int stride = field->width + 1;
+    char column[MAX_HEIGHT];
+    
+    // Клетки хранятся по столбцам (grid[x][y]), поэтому столбец обрабатывается
+    // целиком и раскладывается по строкам буфера
+    for (int x = 0; x < field->width; x++) {
+        field_render_column(field->grid[x], field->height, column);
+        char* out = buffer + x;
+        for (int y = 0; y < field->height; y++) {
+            out[y * stride] = column[y];
         }
-        fprintf(output, "\n");
     }
+    
+    for (int y = 0; y < field->height; y++) {
+        buffer[y * stride + field->width] = '\n';
+    }
+    
+    return stride * field->height;
+}
+
+// Вывод поля в файл
+void field_print(Field* field, FILE* output) {
+    static char buffer[FIELD_RENDER_BUFFER_SIZE];
+    int length = field_render(field, buffer);
+    fwrite(buffer, 1, length, output);
 }
 
 // Вывод поля в консоль
 void field_display(Field* field) {
+    static char buffer[FIELD_RENDER_BUFFER_SIZE];
+    int length = field_render(field, buffer);
+    
     printf("\n");
-    for (int y = 0; y < field->height; y++) {
-        for (int x = 0; x < field->width; x++) {
-            Cell* cell = &field->grid[x][y];
-            if (cell->color != '\0') {
-                printf("%c", cell->color);
-            } else {
-                printf("%c", (char)cell->type);
-            }
-        }
-        printf("\n");
-    }
+    fwrite(buffer, 1, length, stdout);
     printf("Dino at position: (%d, %d)\n\n", field->dino_x, field->dino_y);
 }
 
@@ -393,32 +568,366 @@ void field_copy(Field* dest, const Field* src) {
     dest->height = src->height;
     dest->dino_x = src->dino_x;
     dest->dino_y = src->dino_y;
+    dest->hash = src->hash;
     
-    // Копирование всех клеток
-    for (int i = 0; i < MAX_WIDTH; i++) {
-        for (int j = 0; j < MAX_HEIGHT; j++) {
-            dest->grid[i][j] = src->grid[i][j];
+    // Копирование клеток в пределах размеров поля (остальные всегда пустые)
+    for (int i = 0; i < src->width; i++) {
+        memcpy(dest->grid[i], src->grid[i], src->height * sizeof(Cell));
+    }
+}
+
+// Операции над областью (FILL, CLEAR, REPLACE): каждая применяется к отрезку
+// столбца grid[x][y1..y2], который лежит в памяти подряд
+typedef enum {
+    REGION_FILL_TYPE,
+    REGION_FILL_COLOR,
+    REGION_CLEAR,
+    REGION_REPLACE_TYPE,
+    REGION_REPLACE_COLOR
+} RegionOp;
+
+// Ядро для отрезка столбца. Возвращает число клеток, подходящих под REPLACE
+// (для заливки и очистки - все клетки отрезка).
+// Клетка занимает 8 байт: тип (int) и цвет (char) + выравнивание, поэтому
+// векторная версия обрабатывает две клетки за раз: тип - 32-битные слова 0 и 2,
+// цвет - байты 4 и 12
+static int field_region_column(Cell* column, int count, RegionOp op, char from, char to) {
+    int matched = 0;
+    int y = 0;
+
+    if (sizeof(Cell) == 8) {
+#if defined(__SSE2__)
+        const __m128i type_lanes = _mm_setr_epi32(-1, 0, -1, 0);
+        const __m128i color_lanes = _mm_setr_epi32(0, 0xFF, 0, 0xFF);
+        const __m128i empty = _mm_setr_epi32(CELL_EMPTY, 0, CELL_EMPTY, 0);
+        __m128i to_type = _mm_set1_epi32((unsigned char)to);
+        __m128i from_type = _mm_set1_epi32((unsigned char)from);
+        __m128i to_color = _mm_set1_epi8(to);
+        __m128i from_color = _mm_set1_epi8(from);
+
+        for (; y + 2 <= count; y += 2) {
+            __m128i* src = (__m128i*)(column + y);
+            __m128i cells = _mm_loadu_si128(src);
+            __m128i mask;
+            __m128i value;
+            switch (op) {
+                case REGION_FILL_TYPE:    mask = type_lanes;  value = to_type;  break;
+                case REGION_FILL_COLOR:   mask = color_lanes; value = to_color; break;
+                case REGION_CLEAR:        _mm_storeu_si128(src, empty); continue;
+                case REGION_REPLACE_TYPE:
+                    mask = _mm_and_si128(_mm_cmpeq_epi32(cells, from_type), type_lanes);
+                    value = to_type;
+                    break;
+                default:
+                    mask = _mm_and_si128(_mm_cmpeq_epi8(cells, from_color), color_lanes);
+                    value = to_color;
+                    break;
+            }
+            if (op == REGION_REPLACE_TYPE || op == REGION_REPLACE_COLOR) {
+                // Две клетки: по одному биту на каждую половину регистра
+                int bits = _mm_movemask_epi8(mask);
+                matched += ((bits & 0x00FF) != 0) + ((bits & 0xFF00) != 0);
+            }
+            _mm_storeu_si128(src, _mm_or_si128(_mm_andnot_si128(mask, cells), _mm_and_si128(mask, value)));
+        }
+#endif
+    }
+
+    // Скалярный остаток (и вариант без SIMD)
+    for (; y < count; y++) {
+        Cell* cell = &column[y];
+        switch (op) {
+            case REGION_FILL_TYPE:  cell->type = (CellType)to; break;
+            case REGION_FILL_COLOR: cell->color = to; break;
+            case REGION_CLEAR:      cell->type = CELL_EMPTY; cell->color = '\0'; break;
+            case REGION_REPLACE_TYPE:
+                if (cell->type == (CellType)from) { cell->type = (CellType)to; matched++; }
+                break;
+            case REGION_REPLACE_COLOR:
+                if (cell->color == from) { cell->color = to; matched++; }
+                break;
         }
     }
+
+    if (op == REGION_REPLACE_TYPE || op == REGION_REPLACE_COLOR) {
+        return matched;
+    }
+    return count;
 }
 
-// Загрузка поля из файла
-int field_load_from_file(Field* field, const char* filename) {
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        printf("Error: Cannot open file '%s'\n", filename);
+// Применение операции к прямоугольнику от (x1, y1) до (x2, y2) включительно.
+// Координаты берутся по модулю размеров поля; если x1 > x2 (y1 > y2), область
+// проходит через край поля (как в IF COUNT). Клетка динозавра не меняется и
+// не входит в возвращаемое число записанных клеток.
+// Хеш считается заново, индексы IF COUNT/NEAREST перестраиваются при следующем запросе
+static int field_region_apply(Field* field, int x1, int y1, int x2, int y2, RegionOp op, char from, char to) {
+    if (field->width == 0 || field->height == 0) {
+        return -1;
+    }
+
+    x1 = ((x1 % field->width) + field->width) % field->width;
+    x2 = ((x2 % field->width) + field->width) % field->width;
+    y1 = ((y1 % field->height) + field->height) % field->height;
+    y2 = ((y2 % field->height) + field->height) % field->height;
+
+    // Область через край делится на две полосы по каждой оси
+    int xs[2][2] = { { x1, x2 }, { 0, x2 } };
+    int ys[2][2] = { { y1, y2 }, { 0, y2 } };
+    int x_parts = 1, y_parts = 1;
+    if (x1 > x2) {
+        xs[0][1] = field->width - 1;
+        x_parts = 2;
+    }
+    if (y1 > y2) {
+        ys[0][1] = field->height - 1;
+        y_parts = 2;
+    }
+
+    Cell dino_cell;
+    int has_dino = field->dino_x != -1 && field->dino_y != -1;
+    if (has_dino) {
+        dino_cell = field->grid[field->dino_x][field->dino_y];
+    }
+
+    int total = 0;
+    for (int i = 0; i < x_parts; i++) {
+        for (int x = xs[i][0]; x <= xs[i][1]; x++) {
+            for (int j = 0; j < y_parts; j++) {
+                total += field_region_column(&field->grid[x][ys[j][0]], ys[j][1] - ys[j][0] + 1, op, from, to);
+            }
+        }
+    }
+
+    if (has_dino) {
+        Cell* cell = &field->grid[field->dino_x][field->dino_y];
+        if (op == REGION_REPLACE_TYPE || op == REGION_REPLACE_COLOR) {
+            if (cell->type != dino_cell.type || cell->color != dino_cell.color) {
+                total--;  // Замена в клетке динозавра отменяется
+            }
+        } else {
+            // Клетка динозавра не заливается и не очищается
+            int dx = field->dino_x;
+            int dy = field->dino_y;
+            int inside_x = x1 <= x2 ? (dx >= x1 && dx <= x2) : (dx >= x1 || dx <= x2);
+            int inside_y = y1 <= y2 ? (dy >= y1 && dy <= y2) : (dy >= y1 || dy <= y2);
+            if (inside_x && inside_y) {
+                total--;
+            }
+        }
+        *cell = dino_cell;
+    }
+    field_rehash(field);
+    counts_invalidate(field->counts);
+    return total;
+}
+
+// Символ слоя объектов (для FILL и REPLACE; динозавр не ставится и не заменяется)
+static int field_is_object_symbol(char symbol) {
+    return (cell_flags((CellType)symbol) & CELL_FLAG_OBJECT) != 0;
+}
+
+// Заливка области объектом (цвета сохраняются) или цветом (объекты сохраняются).
+// Возвращает число клеток области без клетки динозавра, -1 - поле не задано, -12 - недопустимый символ
+int field_fill_region(Field* field, int x1, int y1, int x2, int y2, char symbol) {
+    if (symbol >= 'a' && symbol <= 'z') {
+        return field_region_apply(field, x1, y1, x2, y2, REGION_FILL_COLOR, 0, symbol);
+    }
+    if (!field_is_object_symbol(symbol)) {
+        return -12;
+    }
+    return field_region_apply(field, x1, y1, x2, y2, REGION_FILL_TYPE, 0, symbol);
+}
+
+// Очистка области: пустые клетки без цвета
+int field_clear_region(Field* field, int x1, int y1, int x2, int y2) {
+    return field_region_apply(field, x1, y1, x2, y2, REGION_CLEAR, 0, 0);
+}
+
+// Замена объекта объектом или цвета цветом в области. Возвращает число замененных клеток
+int field_replace_region(Field* field, int x1, int y1, int x2, int y2, char from, char to) {
+    if (from >= 'a' && from <= 'z' && to >= 'a' && to <= 'z') {
+        return field_region_apply(field, x1, y1, x2, y2, REGION_REPLACE_COLOR, from, to);
+    }
+    if (!field_is_object_symbol(from) || !field_is_object_symbol(to)) {
+        return -12;
+    }
+    return field_region_apply(field, x1, y1, x2, y2, REGION_REPLACE_TYPE, from, to);
+}
+
+// Заполнение клетки по символу из файла
+static void field_set_cell_from_symbol(Field* field, int x, int y, char symbol) {
+    Cell* cell = &field->grid[x][y];
+
+    if (symbol >= 'a' && symbol <= 'z') {
+        // Цветная клетка
+        cell->type = CELL_EMPTY;
+        cell->color = symbol;
+        return;
+    }
+
+    // Объект (символ объекта совпадает со значением типа), неизвестные символы - пустые клетки
+    cell->color = '\0';
+    if (symbol == CELL_DINO) {
+        cell->type = CELL_DINO;
+        field->dino_x = x;
+        field->dino_y = y;
+        field_heat_visit(field, x, y);
+    } else if (field_is_object_symbol(symbol)) {
+        cell->type = (CellType)symbol;
+    } else {
+        cell->type = CELL_EMPTY;
+    }
+}
+
+// Длина строки без символов перевода строки
+static int field_line_length(const char* line) {
+    int length = strlen(line);
+    while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+        length--;
+    }
+    return length;
+}
+
+// Разбор очередной серии RLE: "120_" -> count = 120, symbol = '_'
+// Возвращает количество прочитанных символов или 0 при ошибке
+static int field_rle_next_run(const char* line, int length, int pos, int* count, char* symbol) {
+    int start = pos;
+    int value = 0;
+    int has_digits = 0;
+
+    while (pos < length && line[pos] >= '0' && line[pos] <= '9') {
+        if (value <= MAX_WIDTH) {
+            value = value * 10 + (line[pos] - '0');
+        }
+        has_digits = 1;
+        pos++;
+    }
+
+    if (pos >= length) {
+        return 0;  // Число без символа
+    }
+
+    *count = has_digits ? value : 1;
+    *symbol = line[pos];
+    return pos - start + 1;
+}
+
+// Длина строки поля после распаковки RLE (-1 при ошибке)
+static int field_rle_decoded_length(const char* line, int length) {
+    int total = 0;
+    int pos = 0;
+
+    while (pos < length) {
+        int count;
+        char symbol;
+        int consumed = field_rle_next_run(line, length, pos, &count, &symbol);
+        if (consumed == 0 || count <= 0) {
+            return -1;
+        }
+        total += count;
+        if (total > MAX_WIDTH) {
+            return total;  // Дальше считать нет смысла, размер уже недопустим
+        }
+        pos += consumed;
+    }
+
+    return total;
+}
+
+// Распаковка строки файла поля (обычной или RLE) в символы клеток (шаблоны STAMP).
+// out - не меньше MAX_WIDTH символов. Возвращает длину строки или -1 при ошибке
+int field_decode_line(const char* line, int is_rle, char* out) {
+    int length = field_line_length(line);
+
+    if (!is_rle) {
+        if (length > MAX_WIDTH) {
+            return -1;
+        }
+        memcpy(out, line, length);
+        return length;
+    }
+
+    if (field_rle_decoded_length(line, length) > MAX_WIDTH) {
         return -1;
     }
+    int x = 0;
+    int pos = 0;
+    while (pos < length) {
+        int count;
+        char symbol;
+        int consumed = field_rle_next_run(line, length, pos, &count, &symbol);
+        if (consumed == 0 || count <= 0) {
+            return -1;
+        }
+        memset(out + x, symbol, count);
+        x += count;
+        pos += consumed;
+    }
+    return x;
+}
+
+// Вывод поля в файл в формате RLE (каждая строка поля - серии "N символ")
+void field_print_rle(Field* field, FILE* output) {
+    static char frame[FIELD_RENDER_BUFFER_SIZE];
+    // Максимальная длина строки: каждая клетка - отдельная серия из одного символа
+    char buffer[MAX_WIDTH + 2];
+    int stride = field->width + 1;
     
-    char line[MAX_WIDTH + 2];  // +2 для \n и \0
+    field_render(field, frame);
+    
+    for (int y = 0; y < field->height; y++) {
+        const char* row = frame + y * stride;
+        int length = 0;
+        int x = 0;
+        
+        while (x < field->width) {
+            char symbol = row[x];
+            int run_end = x + 1;
+            while (run_end < field->width && row[run_end] == symbol) {
+                run_end++;
+            }
+            
+            int count = run_end - x;
+            if (count > 1) {
+                length += snprintf(buffer + length, sizeof(buffer) - length, "%d", count);
+            }
+            buffer[length++] = symbol;
+            x = run_end;
+        }
+        
+        buffer[length++] = '\n';
+        fwrite(buffer, 1, length, output);
+    }
+}
+
+// Загрузка поля из открытого файла (обычный или RLE формат определяется автоматически).
+// filename - только для сообщений
+int field_load_from_stream(Field* field, FILE* file, const char* filename) {
+    // Строка RLE может быть длиннее строки поля (например "1_1_1_")
+    char line[4 * MAX_WIDTH + 2];  // +2 для \n и \0
     int height = 0;
     int width = 0;
+    int is_rle = 0;
+    
+    // Цифры не встречаются в обычном формате - по ним определяется RLE
+    while (fgets(line, sizeof(line), file)) {
+        if (strpbrk(line, "0123456789") != NULL) {
+            is_rle = 1;
+            break;
+        }
+    }
+    fseek(file, 0, SEEK_SET);
     
     // Чтение файла для определения размеров
     while (fgets(line, sizeof(line), file)) {
-        int line_length = strlen(line);
-        if (line[line_length - 1] == '\n') {
-            line_length--;
+        int line_length = field_line_length(line);
+        
+        if (is_rle) {
+            line_length = field_rle_decoded_length(line, line_length);
+            if (line_length < 0) {
+                printf("Error: Invalid RLE data in file '%s' at line %d\n", filename, height + 1);
+                return -1;
+            }
         }
         
         if (line_length > width) {
@@ -430,55 +939,61 @@ int field_load_from_file(Field* field, const char* filename) {
     // Проверка допустимых размеров
     if (width < MIN_SIZE || width > MAX_WIDTH || height < MIN_SIZE || height > MAX_HEIGHT) {
         printf("Error: Invalid field size in file: %dx%d\n", width, height);
-        fclose(file);
         return -1;
     }
     
     // К началу файла
     fseek(file, 0, SEEK_SET);
     
-    // Инициализация поля
-    field_init(field);
+    // Сброс поля (счетчики активности и индексы IF COUNT/NEAREST сохраняются)
+    field_reset(field);
     field->width = width;
     field->height = height;
     
     // Загрузка данных из файла
     int y = 0;
     while (fgets(line, sizeof(line), file) && y < height) {
-        int line_length = strlen(line);
-        if (line[line_length - 1] == '\n') {
-            line_length--;
-        }
+        int line_length = field_line_length(line);
         
-        for (int x = 0; x < line_length && x < width; x++) {
-            Cell* cell = field_get_cell(field, x, y);
-            
-            if (line[x] >= 'a' && line[x] <= 'z') {
-                // Цветная клетка
-                cell->type = CELL_EMPTY;
-                cell->color = line[x];
-            } else {
-                // Объект
-                cell->color = '\0';
-                switch (line[x]) {
-                    case '_': cell->type = CELL_EMPTY; break;
-                    case '#': 
-                        cell->type = CELL_DINO; 
-                        field->dino_x = x;
-                        field->dino_y = y;
-                        break;
-                    case '%': cell->type = CELL_HOLE; break;
-                    case '^': cell->type = CELL_MOUNTAIN; break;
-                    case '&': cell->type = CELL_TREE; break;
-                    case '@': cell->type = CELL_STONE; break;
-                    default: cell->type = CELL_EMPTY; break;
+        if (is_rle) {
+            // Распаковка целыми сериями
+            int x = 0;
+            int pos = 0;
+            while (pos < line_length && x < width) {
+                int count;
+                char symbol;
+                pos += field_rle_next_run(line, line_length, pos, &count, &symbol);
+                
+                if (symbol == '_') {
+                    x += count;  // Поле уже заполнено пустыми клетками
+                    continue;
                 }
+                for (int end = x + count; x < end && x < width; x++) {
+                    field_set_cell_from_symbol(field, x, y, symbol);
+                }
+            }
+        } else {
+            for (int x = 0; x < line_length && x < width; x++) {
+                field_set_cell_from_symbol(field, x, y, line[x]);
             }
         }
         y++;
     }
+    field_rehash(field);
     
-    fclose(file);
-    printf("Field loaded from '%s': %dx%d\n", filename, width, height);
+    printf("Field loaded from '%s': %dx%d%s\n", filename, width, height, is_rle ? " (RLE)" : "");
     return 0;
-}
\ No newline at end of file
+}
+
+// Загрузка поля из файла
+int field_load_from_file(Field* field, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+    
+    int result = field_load_from_stream(field, file, filename);
+    fclose(file);
+    return result;
+}
@@ -4,11 +4,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 #define MAX_WIDTH 100
 #define MAX_HEIGHT 100
 #define MIN_SIZE 10
 
+// Размер буфера для текстового представления поля (строки с '\n')
+#define FIELD_RENDER_BUFFER_SIZE (MAX_HEIGHT * (MAX_WIDTH + 1))
+
 // Типы клеток поля
 typedef enum {
     CELL_EMPTY = '_',
@@ -19,12 +23,42 @@ typedef enum {
     CELL_STONE = '@'
 } CellType;
 
+// Свойства типов клеток (cell_properties, индекс - символ типа). Новый тип клетки -
+// значение в CellType и строка таблицы в field.c
+#define CELL_FLAG_OBJECT        0x0001  // Символ слоя объектов (LOAD, FILL, REPLACE, STAMP, TICK)
+#define CELL_FLAG_BUILDABLE     0x0002  // На клетке создаются объекты (DIG, MOUND, GROW, MAKE)
+#define CELL_FLAG_BLOCKS        0x0004  // Непроходима: MOVE не выполняется, JUMP останавливается перед ней
+#define CELL_FLAG_FATAL         0x0008  // Динозавр гибнет, войдя в клетку (MOVE, приземление JUMP)
+#define CELL_FLAG_CUTTABLE      0x0010  // Срубается CUT
+#define CELL_FLAG_PUSHABLE      0x0020  // Сдвигается PUSH
+#define CELL_FLAG_STOPS_PUSH    0x0040  // Сдвигаемый объект не входит в клетку
+#define CELL_FLAG_BOUNCES_PUSH  0x0080  // Сдвигаемый объект отскакивает от клетки
+#define CELL_FLAG_FILLED_BY_PUSH 0x0100 // Сдвигаемый объект засыпает клетку, обе становятся пустыми
+#define CELL_FLAG_OCCUPIED      0x0200  // Клетка динозавра (препятствие для других динозавров толпы)
+
+typedef struct {
+    uint16_t flags;
+    const char* name;       // Название в сообщениях ("tree"), NULL - не символ типа
+} CellProperties;
+
+extern const CellProperties cell_properties[256];
+
+static inline uint16_t cell_flags(CellType type) {
+    return cell_properties[(unsigned char)type].flags;
+}
+
 // Структура для представления клетки
 typedef struct {
     CellType type;
     char color;  // '\0' если нет цвета, иначе строчная латинская буква
 } Cell;
 
+// Счетчики активности по клеткам (heatmap.h)
+typedef struct FieldHeatmap FieldHeatmap;
+
+// Индексы символов поля (counts.h)
+typedef struct FieldCounts FieldCounts;
+
 // Структура для представления игрового поля
 typedef struct {
     Cell grid[MAX_WIDTH][MAX_HEIGHT];
@@ -32,10 +66,14 @@ typedef struct {
     int height;
     int dino_x;
     int dino_y;
+    uint64_t hash;          // Хеш Зобриста клеток (обновляется field_* при каждом изменении)
+    FieldHeatmap* heatmap;  // Счетчики активности (NULL - выключены, не копируются в историю)
+    FieldCounts* counts;    // Индексы для IF COUNT/NEAREST (NULL - не используются, не копируются в историю)
 } Field;
 
 // Функции
 void field_init(Field* field);
+void field_reset(Field* field);
 int field_set_size(Field* field, int width, int height);
 int field_set_dino_position(Field* field, int x, int y);
 int field_move_dino(Field* field, int dx, int dy);
@@ -45,11 +83,21 @@ int field_cut_tree(Field* field, int dx, int dy);
 int field_push_stone(Field* field, int dx, int dy);
 int field_jump_dino(Field* field, int dx, int dy, int distance);
 Cell* field_get_cell(Field* field, int x, int y);
+void field_set_cell(Field* field, int x, int y, Cell cell);
 int field_check_cell_symbol(Field* field, int x, int y, char symbol);
+int field_render(const Field* field, char* buffer);
 void field_print(Field* field, FILE* output);
+void field_print_rle(Field* field, FILE* output);
 void field_display(Field* field);
 const char* field_get_error_message(int error_code);
 void field_copy(Field* dest, const Field* src);
+int field_fill_region(Field* field, int x1, int y1, int x2, int y2, char symbol);
+int field_clear_region(Field* field, int x1, int y1, int x2, int y2);
+int field_replace_region(Field* field, int x1, int y1, int x2, int y2, char from, char to);
+uint64_t field_compute_hash(const Field* field);
+void field_rehash(Field* field);
+int field_decode_line(const char* line, int is_rle, char* out);
 int field_load_from_file(Field* field, const char* filename);
+int field_load_from_stream(Field* field, FILE* file, const char* filename);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "heatmap.h"
+
+#define PGM_MAX_VALUE 65535  // Максимальное значение в формате PGM
+
+// Создание обнуленной карты активности
+FieldHeatmap* heatmap_create(void) {
+    FieldHeatmap* heatmap = calloc(1, sizeof(FieldHeatmap));
+    if (heatmap == NULL) {
+        printf("Error: Cannot allocate heatmap\n");
+    }
+    return heatmap;
+}
+
+// Освобождение карты активности
+void heatmap_destroy(FieldHeatmap* heatmap) {
+    free(heatmap);
+}
+
+// Проверка расширения имени файла (без учета регистра)
+static int heatmap_has_extension(const char* filename, const char* extension) {
+    size_t length = strlen(filename);
+    size_t ext_length = strlen(extension);
+    return length >= ext_length && strcasecmp(filename + length - ext_length, extension) == 0;
+}
+
+// Вывод всех счетчиков в CSV: x,y,visits,failed_moves,mutations
+static int heatmap_save_csv(const FieldHeatmap* heatmap, const Field* field, const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        printf("Error: Cannot create heatmap file '%s'\n", filename);
+        return -1;
+    }
+    
+    fprintf(file, "x,y,visits,failed_moves,mutations\n");
+    for (int y = 0; y < field->height; y++) {
+        for (int x = 0; x < field->width; x++) {
+            fprintf(file, "%d,%d,%u,%u,%u\n", x, y, heatmap->visits[x][y],
+                    heatmap->failed_moves[x][y], heatmap->mutations[x][y]);
+        }
+    }
+    
+    fclose(file);
+    printf("Heatmap saved to '%s'\n", filename);
+    return 0;
+}
+
+// Вывод одного счетчика как изображения PGM (текстовый вариант P2)
+static int heatmap_save_pgm(const unsigned int counters[MAX_WIDTH][MAX_HEIGHT], const Field* field,
+                            const char* filename) {
+    unsigned int max_count = 0;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            if (counters[x][y] > max_count) max_count = counters[x][y];
+        }
+    }
+    
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        printf("Error: Cannot create heatmap file '%s'\n", filename);
+        return -1;
+    }
+    
+    // Большие значения масштабируются в допустимый для PGM диапазон
+    unsigned int max_value = (max_count > PGM_MAX_VALUE) ? PGM_MAX_VALUE : (max_count > 0 ? max_count : 1);
+    fprintf(file, "P2\n%d %d\n%u\n", field->width, field->height, max_value);
+    for (int y = 0; y < field->height; y++) {
+        for (int x = 0; x < field->width; x++) {
+            unsigned int value = counters[x][y];
+            if (max_count > PGM_MAX_VALUE) {
+                value = (unsigned int)((double)value * PGM_MAX_VALUE / max_count);
+            }
+            fprintf(file, "%s%u", (x > 0) ? " " : "", value);
+        }
+        fprintf(file, "\n");
+    }
+    
+    fclose(file);
+    printf("Heatmap saved to '%s'\n", filename);
+    return 0;
+}
+
+// Сохранение карты активности.
+// *.csv - все счетчики в одном файле; иначе PGM: посещения в filename,
+// неудачные ходы и изменения в <имя>_failed.pgm и <имя>_mutations.pgm
+int heatmap_save(const FieldHeatmap* heatmap, const Field* field, const char* filename) {
+    if (heatmap == NULL || field == NULL || filename == NULL) return -1;
+    
+    if (heatmap_has_extension(filename, ".csv")) {
+        return heatmap_save_csv(heatmap, field, filename);
+    }
+    
+    char base[256];
+    strncpy(base, filename, sizeof(base) - 1);
+    base[sizeof(base) - 1] = '\0';
+    if (heatmap_has_extension(base, ".pgm")) {
+        base[strlen(base) - 4] = '\0';
+    }
+    
+    char failed_name[300];
+    char mutations_name[300];
+    snprintf(failed_name, sizeof(failed_name), "%s_failed.pgm", base);
+    snprintf(mutations_name, sizeof(mutations_name), "%s_mutations.pgm", base);
+    
+    int result = heatmap_save_pgm(heatmap->visits, field, filename);
+    result |= heatmap_save_pgm(heatmap->failed_moves, field, failed_name);
+    result |= heatmap_save_pgm(heatmap->mutations, field, mutations_name);
+    return result;
+}
@@ -0,0 +1,18 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "field.h"
+
+// Счетчики активности по клеткам поля (--heatmap)
+struct FieldHeatmap {
+    unsigned int visits[MAX_WIDTH][MAX_HEIGHT];         // Посещения клетки динозавром
+    unsigned int failed_moves[MAX_WIDTH][MAX_HEIGHT];   // Неудачные попытки войти в клетку
+    unsigned int mutations[MAX_WIDTH][MAX_HEIGHT];      // Изменения клетки (DIG/MOUND/GROW/MAKE/CUT/PUSH/PAINT)
+};
+
+// Функции карты активности
+FieldHeatmap* heatmap_create(void);
+void heatmap_destroy(FieldHeatmap* heatmap);
+int heatmap_save(const FieldHeatmap* heatmap, const Field* field, const char* filename);
+
+#endif
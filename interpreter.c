@@ -1,8 +1,10 @@
 #include "interpreter.h"
+#include "counts.h"
 #include "commands.h"
 #include "utils.h"
 #include <unistd.h>
 #include <stdio.h>
+#include <limits.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -10,12 +12,8 @@
 #include <unistd.h>
 #endif
 
-// Инициализация контекста интерпретатора
-void interpreter_init(InterpreterContext* context) {
-    if (context == NULL) return;
-    
-    // Инициализация основных полей
-    field_init(&context->field);
+// Начальные значения флагов, сообщений и счетчиков (без выделенной памяти)
+static void interpreter_reset_state(InterpreterContext* context) {
     context->field_initialized = 0;
     context->dino_placed = 0;
     context->error_occurred = 0;
@@ -26,15 +24,85 @@ void interpreter_init(InterpreterContext* context) {
     strcpy(context->current_filename, "");
     context->exec_depth = 0;
     
+    // Инициализация счетчиков производительности
+    context->timing_enabled = 0;
+    context->commands_executed = 0;
+    context->parse_time = 0.0;
+    context->command_warned = 0;
+    context->display_time = 0.0;
+    
     // Инициализация истории для UNDO
     context->history_size = 0;
     context->current_history_index = -1;
+    memset(context->history_refs, 0, sizeof(context->history_refs));
     
     // Инициализация предупреждений
     strcpy(context->warning_message, "");
     context->has_warning = 0;
 }
 
+// Инициализация контекста интерпретатора
+void interpreter_init(InterpreterContext* context) {
+    if (context == NULL) return;
+    
+    // Инициализация основных полей
+    field_init(&context->field);
+    stats_init(&context->stats);
+    trace_init(&context->trace, 0);
+    profiler_init(&context->profile);
+    context->path_cache = NULL;
+    context->pattern_cache = NULL;
+    context->script_cache = NULL;
+    context->exec_memo = NULL;
+    context->live_view = NULL;
+    context->history = NULL;
+    context->automaton_pool = NULL;
+    automaton_default_rules(&context->automaton);  // Выделяется при первом сохранении состояния
+    
+    interpreter_reset_state(context);
+}
+
+// Сброс контекста для следующего задания (пул контекстов, --serve).
+// Очищается только использованная часть поля; история, кэш путей и индексы
+// символов остаются выделенными
+void interpreter_reset(InterpreterContext* context) {
+    if (context == NULL) return;
+    
+    field_reset(&context->field);
+    if (context->stats.enabled) {
+        stats_init(&context->stats);
+    }
+    trace_free(&context->trace);
+    profiler_free(&context->profile);
+    
+    interpreter_reset_state(context);
+}
+
+// Освобождение памяти контекста (история, кэши, индексы символов, потоки TICK, трасса, профиль)
+void interpreter_free(InterpreterContext* context) {
+    if (context == NULL) return;
+    
+    free(context->history);
+    context->history = NULL;
+    path_cache_destroy(context->path_cache);
+    context->path_cache = NULL;
+    pattern_cache_destroy(context->pattern_cache);
+    context->pattern_cache = NULL;
+    counts_destroy(context->field.counts);
+    context->field.counts = NULL;
+    memo_destroy(context->exec_memo);
+    context->exec_memo = NULL;
+    automaton_pool_destroy(context->automaton_pool);
+    context->automaton_pool = NULL;
+    if (context->live_view != NULL && context->field_initialized) {
+        liveview_publish(context->live_view, &context->field, context->commands_executed, 1);
+    }
+    liveview_destroy(context->live_view);
+    context->live_view = NULL;
+    trace_free(&context->trace);
+    profiler_free(&context->profile);
+}
+
 // Установка параметров отображения
 void interpreter_set_display_options(InterpreterContext* context, int enabled, double interval) {
     if (context == NULL) return;
@@ -50,6 +118,100 @@ void interpreter_set_save_option(InterpreterContext* context, int enabled) {
     context->save_enabled = enabled;
 }
 
+// Установка параметра замера времени
+void interpreter_set_timing_option(InterpreterContext* context, int enabled) {
+    if (context == NULL) return;
+    
+    context->timing_enabled = enabled;
+}
+
+// Установка параметра сбора статистики
+void interpreter_set_stats_option(InterpreterContext* context, int enabled) {
+    if (context == NULL) return;
+    
+    context->stats.enabled = enabled;
+}
+
+// Включение трассировки (буфер событий выделяется заранее)
+int interpreter_set_trace_option(InterpreterContext* context, long capacity) {
+    if (context == NULL) return -1;
+    
+    trace_free(&context->trace);
+    return trace_init(&context->trace, capacity);
+}
+
+// Установка параметра профилирования по строкам
+void interpreter_set_profile_option(InterpreterContext* context, int enabled) {
+    if (context == NULL) return;
+    
+    context->profile.enabled = enabled;
+}
+
+// Включение кэша результатов EXEC. Кэш переживает interpreter_reset:
+// результаты зависят только от содержимого файла и поля
+int interpreter_set_memo_option(InterpreterContext* context, int enabled) {
+    if (context == NULL) return -1;
+    
+    if (!enabled) {
+        memo_destroy(context->exec_memo);
+        context->exec_memo = NULL;
+    } else if (context->exec_memo == NULL) {
+        context->exec_memo = memo_create();
+        if (context->exec_memo == NULL) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Публикация поля после каждой команды в сегмент разделяемой памяти name (--live)
+int interpreter_set_live_option(InterpreterContext* context, const char* name) {
+    if (context == NULL) return -1;
+    
+    liveview_destroy(context->live_view);
+    context->live_view = (name != NULL) ? liveview_create(name) : NULL;
+    return (name != NULL && context->live_view == NULL) ? -1 : 0;
+}
+
+// Перевод момента времени в микросекунды трассы
+static double interpreter_trace_time(InterpreterContext* context, double seconds) {
+    return (seconds - context->trace.start_time) * 1e6;
+}
+
+// Разбор строки с учетом времени разбора (если включен замер, статистика или трасса)
+int interpreter_parse_line(InterpreterContext* context, const char* line, ParsedCommand* cmd) {
+    if (context == NULL || (!context->timing_enabled && !context->stats.enabled && !context->trace.enabled)) {
+        return parse_line(line, cmd);
+    }
+    
+    double start = get_time_seconds();
+    int result = parse_line(line, cmd);
+    double elapsed = get_time_seconds() - start;
+    
+    context->parse_time += elapsed;
+    if (context->stats.enabled) {
+        stats_record_parse(&context->stats, elapsed * 1e9);
+    }
+    if (context->trace.enabled) {
+        trace_complete(&context->trace, "parse", "parse", interpreter_trace_time(context, start),
+                       elapsed * 1e6, 0, context->exec_depth);
+    }
+    return result;
+}
+
+// Открытие файла скрипта с отметкой в трассе
+FILE* interpreter_open_script(InterpreterContext* context, const char* filename) {
+    if (context == NULL || !context->trace.enabled) {
+        return fopen(filename, "r");
+    }
+    
+    double start = get_time_seconds();
+    FILE* file = fopen(filename, "r");
+    trace_complete(&context->trace, "open", "io", interpreter_trace_time(context, start),
+                   (get_time_seconds() - start) * 1e6, 0, context->exec_depth);
+    return file;
+}
+
 // Получение текста последней ошибки
 const char* interpreter_get_error_message(InterpreterContext* context) {
     return (context != NULL) ? context->error_message : "Context is NULL";
@@ -77,19 +239,57 @@ void wait_for_display(double seconds) {
 void interpreter_save_state(InterpreterContext* context) {
     if (context == NULL || !context->field_initialized) return;
     
-    // Сдвигаем все состояния, если достигли максимального
-    if (context->history_size >= MAX_UNDO_LEVELS) {
-        // Удаление самого первого состояния
-        for (int i = 0; i < MAX_UNDO_LEVELS - 1; i++) {
-            field_copy(&context->history[i], &context->history[i + 1]);
+    // История выделяется при первом сохранении (контексты без команд ее не занимают)
+    if (context->history == NULL) {
+        context->history = malloc(MAX_UNDO_LEVELS * sizeof(Field));
+        if (context->history == NULL) {
+            printf("Error: Cannot allocate undo history\n");
+            return;
         }
+    }
+    
+    // Переполнение: самый старый уровень удаляется, сдвигаются только номера снимков
+    if (context->history_size >= MAX_UNDO_LEVELS) {
+        context->history_refs[context->history_slots[0]]--;
+        memmove(&context->history_slots[0], &context->history_slots[1], (MAX_UNDO_LEVELS - 1) * sizeof(int));
         context->history_size = MAX_UNDO_LEVELS - 1;
     }
     
-    // Сохранение текущего состояния
-    field_copy(&context->history[context->history_size], &context->field);
+    // Поле не изменилось с прошлого сохранения (команда ничего не сделала) -
+    // новый уровень ссылается на тот же снимок, копирования нет
+    int slot = -1;
+    if (context->history_size > 0) {
+        int last = context->history_slots[context->history_size - 1];
+        if (context->history[last].hash == context->field.hash &&
+            context->history[last].dino_x == context->field.dino_x &&
+            context->history[last].dino_y == context->field.dino_y) {
+            slot = last;
+            if (context->stats.enabled) {
+                stats_record_snapshot_elided(&context->stats);
+            }
+        }
+    }
+    
+    // Сохранение текущего состояния в свободный снимок
+    if (slot < 0) {
+        slot = 0;
+        while (context->history_refs[slot] > 0) {
+            slot++;
+        }
+        field_copy(&context->history[slot], &context->field);
+        if (context->stats.enabled) {
+            stats_record_snapshot(&context->stats, (long)(context->field.width * context->field.height * sizeof(Cell)));
+        }
+    }
+    
+    context->history_refs[slot]++;
+    context->history_slots[context->history_size] = slot;
     context->current_history_index = context->history_size;
     context->history_size++;
+    
+    if (context->exec_memo != NULL) {
+        memo_level(context->exec_memo, &context->field);
+    }
 }
 
 // Откат к предыдущему состоянию (UNDO)
@@ -110,7 +310,8 @@ int interpreter_undo(InterpreterContext* context) {
     
     // Возврат к предыдущему состоянию
     context->current_history_index--;
-    field_copy(&context->field, &context->history[context->current_history_index]);
+    field_copy(&context->field, &context->history[context->history_slots[context->current_history_index]]);
+    counts_invalidate(context->field.counts);
     
     printf("Undo successful. Restored state %d of %d\n", 
            context->current_history_index + 1, context->history_size);
@@ -124,6 +325,10 @@ void interpreter_set_warning(InterpreterContext* context, const char* warning) {
         strncpy(context->warning_message, warning, sizeof(context->warning_message) - 1);
         context->warning_message[sizeof(context->warning_message) - 1] = '\0';
         context->has_warning = 1;
+        context->command_warned = 1;
+        if (context->exec_memo != NULL) {
+            memo_warning(context->exec_memo, warning);
+        }
     }
 }
 
@@ -149,11 +354,43 @@ int interpreter_execute_if_command(InterpreterContext* context, ParsedCommand* c
     }
     
     // Проверка условия IF
-    int condition_met = field_check_cell_symbol(&context->field, cmd->x, cmd->y, cmd->color);
+    int condition_met;
+    int count = 0;
+    int nearest_x = -1, nearest_y = -1;
+    if ((cmd->condition == IF_COUNT || cmd->condition == IF_NEAREST) && context->field.counts == NULL) {
+        context->field.counts = counts_create();
+        if (context->field.counts == NULL) {
+            return -1;
+        }
+    }
+    if (cmd->condition == IF_NEAREST) {
+        if (!context->dino_placed) {
+            printf("Error: Dino not placed for IF NEAREST\n");
+            return -2;
+        }
+        count = counts_nearest(context->field.counts, &context->field, context->field.dino_x,
+                               context->field.dino_y, cmd->color, &nearest_x, &nearest_y);
+        condition_met = count >= 0 && count <= cmd->n;
+    } else if (cmd->condition == IF_COUNT) {
+        count = counts_query(context->field.counts, &context->field, cmd->x, cmd->y, cmd->x2, cmd->y2, cmd->color);
+        condition_met = (cmd->compare == '>' && count > cmd->n) ||
+                        (cmd->compare == '<' && count < cmd->n) ||
+                        (cmd->compare == '=' && count == cmd->n);
+    } else {
+        condition_met = field_check_cell_symbol(&context->field, cmd->x, cmd->y, cmd->color);
+    }
     
     if (condition_met) {
-        printf("Condition met! Symbol '%c' found at (%d, %d). Executing: %s\n", 
-               cmd->color, cmd->x, cmd->y, cmd->then_command);
+        if (cmd->condition == IF_NEAREST) {
+            printf("Condition met! Nearest symbol '%c' at (%d, %d), distance %d. Executing: %s\n",
+                   cmd->color, nearest_x, nearest_y, count, cmd->then_command);
+        } else if (cmd->condition == IF_COUNT) {
+            printf("Condition met! %d cells with symbol '%c' in (%d, %d)-(%d, %d). Executing: %s\n",
+                   count, cmd->color, cmd->x, cmd->y, cmd->x2, cmd->y2, cmd->then_command);
+        } else {
+            printf("Condition met! Symbol '%c' found at (%d, %d). Executing: %s\n", 
+                   cmd->color, cmd->x, cmd->y, cmd->then_command);
+        }
         
         // Парсинг и выполнение команды из блока THEN
         ParsedCommand then_cmd;
@@ -181,81 +418,412 @@ int interpreter_execute_if_command(InterpreterContext* context, ParsedCommand* c
         }
         
         return result;
+    } else if (cmd->condition == IF_NEAREST) {
+        if (count < 0) {
+            printf("Condition not met. Symbol '%c' not found on the field\n", cmd->color);
+        } else {
+            printf("Condition not met. Nearest symbol '%c' at (%d, %d), distance %d > %d\n",
+                   cmd->color, nearest_x, nearest_y, count, cmd->n);
+        }
+        return 0;
+    } else if (cmd->condition == IF_COUNT) {
+        printf("Condition not met. %d cells with symbol '%c' in (%d, %d)-(%d, %d)\n",
+               count, cmd->color, cmd->x, cmd->y, cmd->x2, cmd->y2);
+        return 0;
     } else {
         printf("Condition not met. Symbol '%c' not found at (%d, %d)\n", cmd->color, cmd->x, cmd->y);
         return 0;
     }
 }
 
-// Выполнение команд из файла
+static void interpreter_command_prologue(InterpreterContext* context, CommandType type, int line_number);
+static int interpreter_push_file(InterpreterContext* context, ExecState* state, const char* filename, int top_level);
+
+// Результат EXEC из кэша (--memo-exec). Возвращает 1, если результат применен
+// (result - код EXEC), 0 - результата нет и после входа в файл его нужно записать
+// по ключу key, -1 - EXEC не кэшируется
+static int interpreter_memo_lookup(InterpreterContext* context, const char* filename, MemoKey* key, int* result) {
+    ExecMemo* memo = context->exec_memo;
+    
+    // Записываемый внешний файл зависит от вложенного - его результат не сохраняется
+    memo_cancel(memo);
+    
+    uint64_t script_hash;
+    if (!context->field_initialized || context->exec_depth >= MAX_EXEC_DEPTH ||
+        memo_script_hash(memo, filename, &script_hash) != 0) {
+        return -1;
+    }
+    memo_make_key(key, script_hash, &context->field, context->dino_placed);
+    const MemoEntry* entry = memo_lookup(memo, key);
+    if (entry == NULL) {
+        return 0;
+    }
+    
+    // Уровни UNDO, сохраненные командами файла, повторяются: история та же, что без кэша
+    for (int i = 0; i < entry->level_count; i++) {
+        memo_apply_level(&entry->levels[i], &context->field);
+        interpreter_save_state(context);
+    }
+    memo_apply(entry, &context->field);
+    context->dino_placed = entry->dino_placed;
+    printf("EXEC result reused from memo: %d cells changed\n", entry->cells_changed);
+    for (int i = 0; i < entry->warning_count; i++) {
+        interpreter_set_warning(context, entry->warnings[i]);
+        interpreter_show_warnings(context);
+    }
+    if (entry->warnings_dropped > 0) {
+        printf("(%d more warnings not stored)\n", entry->warnings_dropped);
+    }
+    *result = entry->result;
+    return 1;
+}
+
+// Начало замера команды без учета отображения поля.
+// Предупреждения вложенных команд (EXEC, THEN) учитываются у них самих и у внешней команды
+static void interpreter_timing_begin(InterpreterContext* context, CommandTiming* timing) {
+    if (!context->stats.enabled && !context->trace.enabled) {
+        return;
+    }
+    timing->outer_warned = context->command_warned;
+    timing->display_before = context->display_time;
+    context->command_warned = 0;
+    timing->start = get_time_seconds();
+}
+
+// Конец замера: запись в статистику и трассу
+static void interpreter_timing_end(InterpreterContext* context, CommandTiming* timing, CommandType type,
+                                   int result, int line_number) {
+    if (!context->stats.enabled && !context->trace.enabled) {
+        return;
+    }
+    double elapsed = get_time_seconds() - timing->start;
+    
+    if (context->stats.enabled) {
+        // Отрицательный код после предупреждения (своего или вложенной команды) - не ошибка,
+        // если выполнение не остановлено
+        int failed = result < 0 && (context->error_occurred || !context->command_warned);
+        stats_record_command(&context->stats, type,
+                             (elapsed - (context->display_time - timing->display_before)) * 1e9,
+                             context->command_warned && !failed, failed);
+    }
+    if (context->trace.enabled) {
+        // В трассе интервал команды полный (с отображением), чтобы вложенность сохранялась
+        trace_complete(&context->trace, command_type_name(type), "command",
+                       interpreter_trace_time(context, timing->start), elapsed * 1e6,
+                       line_number, context->exec_depth);
+    }
+    context->command_warned |= timing->outer_warned;
+}
+
+// Выполнение команд из файла (EXEC внутри THEN): файл выполняется до конца
 int interpreter_execute_file(InterpreterContext* context, const char* filename) {
     if (context == NULL || filename == NULL) {
         printf("Error: Null pointer when executing file\n");
         return -1;
     }
     
-    // Проверка глубины вложенности (защита от бесконечной рекурсии)
-    if (context->exec_depth >= 10) {
-        printf("Error: Maximum EXEC depth exceeded (10 levels)\n");
-        return -2;
+    MemoKey key;
+    int memo_status = -1;
+    int result;
+    if (context->exec_memo != NULL) {
+        memo_status = interpreter_memo_lookup(context, filename, &key, &result);
+        if (memo_status == 1) {
+            return result;
+        }
     }
     
-    // Сохранение текущего имени файла
-    char old_filename[256];
-    strcpy(old_filename, context->current_filename);
-    strcpy(context->current_filename, filename);
-    context->exec_depth++;
+    ExecState state;
+    state.depth = 0;
+    result = interpreter_push_file(context, &state, filename, 0);
+    if (result != 0) {
+        return result;
+    }
+    if (memo_status == 0) {
+        memo_begin(context->exec_memo, &key, &context->field, context->exec_depth);
+    }
+    return interpreter_run(context, &state);
+}
+
+// Выполнение заранее разобранного основного скрипта
+int interpreter_execute_parsed(InterpreterContext* context, ParsedScript* script) {
+    ExecState state;
+    interpreter_start_parsed(context, &state, script);
+    return interpreter_run(context, &state);
+}
+
+// Новый кадр файла на вершине стека. Для вложенного файла - вход в файл (EXEC).
+// Возвращает 0, -2 при превышении глубины или -3, если файл не открывается
+static int interpreter_push_file(InterpreterContext* context, ExecState* state, const char* filename, int top_level) {
+    // Проверка глубины до занятия кадра: стек рассчитан на MAX_EXEC_DEPTH вложенных файлов
+    char saved_filename[256] = "";
+    if (!top_level) {
+        int enter_result = interpreter_enter_file(context, filename, saved_filename);
+        if (enter_result != 0) {
+            return enter_result;
+        }
+    }
     
-    printf("=== Executing file: %s (depth: %d) ===\n", filename, context->exec_depth);
+    ExecFrame* frame = &state->frames[state->depth];
+    snprintf(frame->filename, sizeof(frame->filename), "%s", filename);
+    strcpy(frame->saved_filename, saved_filename);
+    frame->file = NULL;
+    frame->script = NULL;
+    frame->next_line = 0;
+    frame->line_number = 0;
+    frame->top_level = top_level;
+    frame->result = 0;
+    frame->start = context->trace.enabled ? get_time_seconds() : 0.0;
     
-    // Открытие файла
-    FILE* file = fopen(filename, "r");
-    if (file == NULL) {
-        printf("Error: Cannot open file '%s'\n", filename);
-        // Восстанавление предыдущее состояние
-        strcpy(context->current_filename, old_filename);
-        context->exec_depth--;
-        return -3;
+    // Разобранный файл из кэша (--serve, сессии) или построчное чтение
+    if (context->script_cache != NULL) {
+        frame->script = script_cache_get(context->script_cache, filename);
+    }
+    if (frame->script != NULL) {
+        frame->script->pins++;
+    } else {
+        frame->file = interpreter_open_script(context, filename);
+        if (frame->file == NULL) {
+            if (!top_level) {
+                printf("Error: Cannot open file '%s'\n", filename);
+                // Восстановление предыдущего состояния
+                strcpy(context->current_filename, frame->saved_filename);
+                context->exec_depth--;
+            }
+            return -3;
+        }
     }
     
-    // Чтение и выполнение команд из файла
-    char line[MAX_LINE_LENGTH];
-    int line_number = 0;
-    int result = 0;
+    frame->profile_index = profiler_file_index(&context->profile, filename);
+    state->depth++;
+    return 0;
+}
+
+// Выполнение основного скрипта по шагам: первый кадр стека
+int interpreter_start_file(InterpreterContext* context, ExecState* state, const char* filename) {
+    state->depth = 0;
+    state->result = 0;
+    return interpreter_push_file(context, state, filename, 1);
+}
+
+// То же для уже разобранного скрипта (он закрепляется до конца выполнения)
+void interpreter_start_parsed(InterpreterContext* context, ExecState* state, ParsedScript* script) {
+    ExecFrame* frame = &state->frames[0];
+    snprintf(frame->filename, sizeof(frame->filename), "%s", script->filename);
+    frame->file = NULL;
+    frame->script = script;
+    frame->script->pins++;
+    frame->next_line = 0;
+    frame->line_number = 0;
+    frame->top_level = 1;
+    frame->result = 0;
+    frame->start = 0.0;
+    frame->profile_index = profiler_file_index(&context->profile, frame->filename);
+    state->depth = 1;
+    state->result = 0;
+}
+
+// Следующая команда кадра: 1 - команда в cmd, -1 - ошибка разбора (текст в *text),
+// 0 - файл закончился
+static int interpreter_next_command(InterpreterContext* context, ExecFrame* frame, ParsedCommand* cmd, const char** text) {
+    if (frame->script != NULL) {
+        if (frame->next_line >= frame->script->count) {
+            return 0;
+        }
+        const ScriptLine* line = &frame->script->lines[frame->next_line++];
+        frame->line_number = line->line_number;
+        *text = line->text;
+        if (!line->parsed) {
+            parse_line(line->text, cmd);  // Повтор сообщения парсера
+            return -1;
+        }
+        *cmd = line->cmd;
+        return 1;
+    }
     
-    while (read_line(file, line, sizeof(line)) != NULL && !context->error_occurred) {
-        line_number++;
-        
+    // Пропуск комментариев
+    while (read_line(frame->file, frame->line, sizeof(frame->line)) != NULL) {
+        frame->line_number++;
+        *text = frame->line;
+        if (interpreter_parse_line(context, frame->line, cmd) != 0) {
+            return -1;
+        }
+        if (cmd->type != CMD_COMMENT) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Фатальная ошибка команды кадра: сообщение, остаток файла не выполняется
+static void interpreter_check_fatal(InterpreterContext* context, ExecFrame* frame) {
+    if (frame->result < 0 && context->error_occurred) {
+        if (frame->top_level) {
+            printf("Fatal error at line %d: %s\n", frame->line_number, interpreter_get_error_message(context));
+        } else {
+            printf("Fatal error at line %d in %s: %s\n", frame->line_number, frame->filename,
+                   interpreter_get_error_message(context));
+        }
+    }
+}
+
+// Завершение команды EXEC в родительском кадре (после выполнения или ошибки входа в файл)
+static void interpreter_finish_exec(InterpreterContext* context, ExecFrame* parent, const char* filename, int result,
+                                    CommandTiming* timing, const ProfileMark* mark, int line_number) {
+    if (result != 0) {
+        printf("EXEC failed for file: %s\n", filename);
+    }
+    interpreter_end_command(context);
+    interpreter_timing_end(context, timing, CMD_EXEC, result, line_number);
+    profiler_line_end(&context->profile, mark, parent->profile_index, line_number);
+    
+    parent->result = result;
+    interpreter_check_fatal(context, parent);
+}
+
+// Начало команды EXEC: вместо рекурсии файл становится новым кадром стека
+static void interpreter_push_exec(InterpreterContext* context, ExecState* state, ParsedCommand* cmd) {
+    ExecFrame* parent = &state->frames[state->depth - 1];
+    int line_number = parent->line_number;
+    CommandTiming timing;
+    ProfileMark mark;
+    
+    profiler_line_begin(&context->profile, &mark);
+    context->commands_executed++;
+    interpreter_timing_begin(context, &timing);
+    interpreter_command_prologue(context, CMD_EXEC, line_number);
+    printf("EXEC %s\n", cmd->filename);
+    
+    MemoKey key;
+    int memo_status = -1;
+    int result;
+    if (context->exec_memo != NULL) {
+        memo_status = interpreter_memo_lookup(context, cmd->filename, &key, &result);
+        if (memo_status == 1) {
+            interpreter_finish_exec(context, parent, cmd->filename, result, &timing, &mark, line_number);
+            return;
+        }
+    }
+    
+    result = interpreter_push_file(context, state, cmd->filename, 0);
+    if (result != 0) {
+        interpreter_finish_exec(context, parent, cmd->filename, result, &timing, &mark, line_number);
+        return;
+    }
+    if (memo_status == 0) {
+        memo_begin(context->exec_memo, &key, &context->field, context->exec_depth);
+    }
+    
+    ExecFrame* frame = &state->frames[state->depth - 1];
+    frame->exec_line = line_number;
+    frame->exec_timing = timing;
+    frame->exec_mark = mark;
+}
+
+// Снятие кадра: выход из файла и завершение EXEC в родительском кадре
+static void interpreter_pop_frame(InterpreterContext* context, ExecState* state) {
+    ExecFrame* frame = &state->frames[--state->depth];
+    
+    if (frame->file != NULL) {
+        fclose(frame->file);
+    } else {
+        frame->script->pins--;
+    }
+    if (!frame->top_level) {
+        if (context->trace.enabled) {
+            trace_file(&context->trace, frame->filename, interpreter_trace_time(context, frame->start),
+                       (get_time_seconds() - frame->start) * 1e6, context->exec_depth);
+        }
+        if (context->exec_memo != NULL) {
+            memo_end(context->exec_memo, context->exec_depth, &context->field, context->dino_placed,
+                     frame->result, context->error_occurred);
+        }
+        interpreter_leave_file(context, frame->filename, frame->saved_filename);
+    }
+    
+    if (state->depth == 0 || frame->top_level) {
+        state->result = frame->result;
+    } else {
+        interpreter_finish_exec(context, &state->frames[state->depth - 1], frame->filename, frame->result,
+                                &frame->exec_timing, &frame->exec_mark, frame->exec_line);
+    }
+}
+
+// Выполнение не больше quota строк. Возвращает число обработанных строк;
+// выполнение закончено, когда стек кадров пуст
+long interpreter_step(InterpreterContext* context, ExecState* state, long quota) {
+    long executed = 0;
+    
+    while (state->depth > 0 && executed < quota) {
+        ExecFrame* frame = &state->frames[state->depth - 1];
         ParsedCommand cmd;
-        int parse_result = parse_line(line, &cmd);
+        const char* text = NULL;
         
-        if (parse_result != 0) {
-            printf("Error parsing line %d in %s: %s\n", line_number, filename, line);
+        int status = context->error_occurred ? 0 : interpreter_next_command(context, frame, &cmd, &text);
+        if (status == 0) {
+            interpreter_pop_frame(context, state);
             continue;
         }
+        executed++;
         
-        if (cmd.type == CMD_COMMENT) {
-            continue;  // Пропуск комментариев
+        if (status < 0) {
+            if (frame->top_level) {
+                printf("Error parsing line %d: %s\n", frame->line_number, text);
+            } else {
+                printf("Error parsing line %d in %s: %s\n", frame->line_number, frame->filename, text);
+            }
+            continue;
         }
         
-        result = interpreter_execute_command(context, &cmd, line_number);
-        if (result < 0 && context->error_occurred) {
-            printf("Fatal error at line %d in %s: %s\n", line_number, filename, 
-                   interpreter_get_error_message(context));
-            break;
+        if (cmd.type == CMD_EXEC) {
+            interpreter_push_exec(context, state, &cmd);
+            continue;
         }
+        
+        ProfileMark mark;
+        profiler_line_begin(&context->profile, &mark);
+        frame->result = interpreter_execute_command(context, &cmd, frame->line_number);
+        profiler_line_end(&context->profile, &mark, frame->profile_index, frame->line_number);
+        interpreter_check_fatal(context, frame);
     }
     
-    fclose(file);
-    printf("=== Finished executing: %s ===\n", filename);
+    return executed;
+}
+
+// Выполнение до конца
+int interpreter_run(InterpreterContext* context, ExecState* state) {
+    while (state->depth > 0) {
+        interpreter_step(context, state, LONG_MAX);
+    }
+    return state->result;
+}
+
+// Вход во вложенный файл (EXEC): проверка глубины, смена текущего имени файла.
+// Прежнее имя сохраняется в saved_filename (не короче 256 символов)
+int interpreter_enter_file(InterpreterContext* context, const char* filename, char* saved_filename) {
+    // Проверка глубины вложенности (защита от бесконечной рекурсии)
+    if (context->exec_depth >= MAX_EXEC_DEPTH) {
+        printf("Error: Maximum EXEC depth exceeded (%d levels)\n", MAX_EXEC_DEPTH);
+        return -2;
+    }
     
-    // Восстановление предыдущего имени файла
-    strcpy(context->current_filename, old_filename);
-    context->exec_depth--;
+    // Сохранение текущего имени файла
+    strcpy(saved_filename, context->current_filename);
+    strcpy(context->current_filename, filename);
+    context->exec_depth++;
     
-    return result;
+    printf("=== Executing file: %s (depth: %d) ===\n", filename, context->exec_depth);
+    return 0;
 }
 
+// Выход из вложенного файла: восстановление прежнего имени файла
+void interpreter_leave_file(InterpreterContext* context, const char* filename, const char* saved_filename) {
+    printf("=== Finished executing: %s ===\n", filename);
+    strcpy(context->current_filename, saved_filename);
+    context->exec_depth--;
+}
+
+static int interpreter_dispatch_command(InterpreterContext* context, ParsedCommand* cmd, int line_number);
+
 // Основная функция выполнения команды
 int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd, int line_number) {
     if (context == NULL || cmd == NULL) {
@@ -268,6 +836,22 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
         return -2;
     }
     
+    context->commands_executed++;
+    
+    if (!context->stats.enabled && !context->trace.enabled) {
+        return interpreter_dispatch_command(context, cmd, line_number);
+    }
+    
+    CommandTiming timing;
+    interpreter_timing_begin(context, &timing);
+    int result = interpreter_dispatch_command(context, cmd, line_number);
+    interpreter_timing_end(context, &timing, cmd->type, result, line_number);
+    
+    return result;
+}
+
+// Начало команды: вывод строки и сохранение состояния для UNDO
+static void interpreter_command_prologue(InterpreterContext* context, CommandType type, int line_number) {
     // Вывод информации о выполняемой команде
     if (strlen(context->current_filename) > 0) {
         printf("Executing %s line %d: ", context->current_filename, line_number);
@@ -275,11 +859,174 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
         printf("Executing line %d: ", line_number);
     }
     
+    // Результат файла с UNDO, LOAD, SIZE или STAMP зависит не только от поля при входе
+    if (context->exec_memo != NULL &&
+        (type == CMD_UNDO || type == CMD_LOAD || type == CMD_SIZE || type == CMD_STAMP)) {
+        memo_cancel(context->exec_memo);
+    }
+    
     // Сохранение состояние перед выполнением команды 
-    if (cmd->type != CMD_UNDO && cmd->type != CMD_LOAD && cmd->type != CMD_EXEC && 
-        cmd->type != CMD_COMMENT && context->field_initialized) {
+    if (type != CMD_UNDO && type != CMD_LOAD && type != CMD_EXEC && 
+        type != CMD_COMMENT && context->field_initialized) {
         interpreter_save_state(context);
     }
+}
+
+// Начало команды скомпилированного скрипта (--emit-c): то же, что делает
+// interpreter_execute_command до выполнения команды; echo - текст команды
+int interpreter_begin_command(InterpreterContext* context, CommandType type, int line_number, const char* echo) {
+    if (context->error_occurred) {
+        return -2;
+    }
+    context->commands_executed++;
+    interpreter_command_prologue(context, type, line_number);
+    printf("%s\n", echo);
+    return 0;
+}
+
+// Проверка размещения динозавра.
+// MOUND, GROW, CUT, MAKE и PUSH без динозавра не останавливают выполнение скрипта
+int interpreter_require_dino(InterpreterContext* context, CommandType type) {
+    if (context->dino_placed) {
+        return 0;
+    }
+    printf("Error: Dino not placed. Use START command first\n");
+    if (type != CMD_MOUND && type != CMD_GROW && type != CMD_CUT && type != CMD_MAKE && type != CMD_PUSH) {
+        context->error_occurred = 1;
+        strcpy(context->error_message, "Dino not placed. Use START command first");
+    }
+    return -1;
+}
+
+// Тип объекта, создаваемого командой DIG/MOUND/GROW/MAKE
+static CellType interpreter_created_type(CommandType type) {
+    switch (type) {
+        case CMD_DIG: return CELL_HOLE;
+        case CMD_MOUND: return CELL_MOUNTAIN;
+        case CMD_GROW: return CELL_TREE;
+        default: return CELL_STONE;
+    }
+}
+
+// Предупреждение о занятой/пустой соседней клетке (dx, dy)
+static void interpreter_warn_target(InterpreterContext* context, const char* format, int dx, int dy) {
+    int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
+    int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
+    char warning[100];
+    snprintf(warning, sizeof(warning), format, target_x, target_y);
+    interpreter_set_warning(context, warning);
+}
+
+// Разбор результата функции field_* для команд MOVE, JUMP, DIG, MOUND, GROW, MAKE, CUT и PUSH:
+// предупреждения и фатальные ошибки. Возвращает результат или -1 при фатальной ошибке
+int interpreter_check_field_result(InterpreterContext* context, CommandType type, int result, int dx, int dy) {
+    switch (type) {
+        case CMD_MOVE:
+            if (result == -4) {
+                context->error_occurred = 1;
+                strcpy(context->error_message, "Dino fell into a hole!");
+                return -1;
+            } else if (result == -3) {
+                interpreter_warn_target(context, "Movement blocked by obstacle at cell (%d, %d)", dx, dy);
+            } else if (result < 0) {
+                printf("Movement error: %s\n", field_get_error_message(result));
+            }
+            break;
+            
+        case CMD_JUMP:
+            if (result == -4) {
+                context->error_occurred = 1;
+                strcpy(context->error_message, "Dino fell into a hole during jump!");
+                return -1;
+            } else if (result == -5) {
+                interpreter_set_warning(context, "Jump blocked - obstacle right in front of dino");
+            } else if (result < -100) {
+                // Извлекаем координаты препятствия из кода ошибки
+                int error_code = -result - 100;
+                int blocked_x = error_code / 1000;
+                int blocked_y = error_code % 1000;
+                char warning[100];
+                snprintf(warning, sizeof(warning), "Jump blocked by obstacle at cell (%d, %d)", blocked_x, blocked_y);
+                interpreter_set_warning(context, warning);
+            } else if (result < 0) {
+                printf("Jump error: %s\n", field_get_error_message(result));
+            }
+            break;
+            
+        case CMD_DIG:
+            if (result == -6) {
+                interpreter_warn_target(context, "Cannot dig hole at cell (%d, %d) - cell is occupied", dx, dy);
+            }
+            break;
+            
+        case CMD_MOUND:
+            if (result == -6) {
+                interpreter_warn_target(context, "Cannot create mountain at cell (%d, %d) - cell is occupied", dx, dy);
+            }
+            break;
+            
+        case CMD_GROW:
+            if (result == -6) {
+                interpreter_warn_target(context, "Cannot grow tree at cell (%d, %d) - cell is occupied", dx, dy);
+            }
+            break;
+            
+        case CMD_MAKE:
+            if (result == -6) {
+                interpreter_warn_target(context, "Cannot create stone at cell (%d, %d) - cell is occupied", dx, dy);
+            }
+            break;
+            
+        case CMD_CUT:
+            if (result == -7) {
+                interpreter_warn_target(context, "Cannot cut at cell (%d, %d) - no tree found", dx, dy);
+            } else if (result < 0) {
+                printf("Cut error: %s\n", field_get_error_message(result));
+            }
+            break;
+            
+        case CMD_PUSH:
+            if (result == -8) {
+                interpreter_warn_target(context, "Cannot push at cell (%d, %d) - no stone found", dx, dy);
+            } else if (result == -9) {
+                interpreter_set_warning(context, "Stone push blocked by obstacle");
+            } else if (result == -10) {
+                interpreter_set_warning(context, "Stone hit tree and bounced back!");
+            } else if (result < 0) {
+                printf("Push error: %s\n", field_get_error_message(result));
+            }
+            break;
+            
+        default:
+            break;
+    }
+    return result;
+}
+
+// Отображение состояния после команды (если включена визуализация)
+void interpreter_end_command(InterpreterContext* context) {
+    if (context->live_view != NULL && context->field_initialized) {
+        liveview_publish(context->live_view, &context->field, context->commands_executed, 0);
+    }
+    
+    if (context->display_enabled && !context->error_occurred) {
+        double display_start = context->stats.enabled ? get_time_seconds() : 0.0;  // Только для --stats
+        clear_screen();
+        field_display(&context->field);
+        interpreter_show_warnings(context);  // Предупреждения после поля
+        wait_for_display(context->display_interval);
+        if (context->stats.enabled) {
+            context->display_time += get_time_seconds() - display_start;
+        }
+    } else if (context->has_warning) {
+        // Если визуализация отключена, всё равно показываются предупреждения
+        interpreter_show_warnings(context);
+    }
+}
+
+// Выполнение команды по типу
+static int interpreter_dispatch_command(InterpreterContext* context, ParsedCommand* cmd, int line_number) {
+    interpreter_command_prologue(context, cmd->type, line_number);
     
     int result = 0;
     int dx, dy;
@@ -328,10 +1075,7 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
             
         case CMD_MOVE: // Перемещение динозавра в указанном направлении
             printf("MOVE %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino not placed. Use START command first");
+            if (interpreter_require_dino(context, cmd->type) != 0) {
                 return -1;
             }
             
@@ -344,29 +1088,16 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
             }
             
             get_direction_offset(move_dir, &dx, &dy);
-            result = field_move_dino(&context->field, dx, dy);
-            
-            if (result == -4) {
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino fell into a hole!");
+            result = interpreter_check_field_result(context, cmd->type,
+                                                    field_move_dino(&context->field, dx, dy), dx, dy);
+            if (context->error_occurred) {
                 return -1;
-            } else if (result == -3) {
-                int new_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int new_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Movement blocked by obstacle at cell (%d, %d)", new_x, new_y);
-                interpreter_set_warning(context, warning);
-            } else if (result < 0) {
-                printf("Movement error: %s\n", field_get_error_message(result));
             }
             break;
             
         case CMD_PAINT: // Закрашивание текущей клетки указанным цветом
             printf("PAINT %c\n", cmd->color);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino not placed. Use START command first");
+            if (interpreter_require_dino(context, cmd->type) != 0) {
                 return -1;
             }
             
@@ -380,64 +1111,41 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
             field_paint_cell(&context->field, cmd->color);
             break;
             
-        case CMD_DIG: // Создание ямы в указанном направлении
-            printf("DIG %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino not placed. Use START command first");
-                return -1;
-            }
-            
-            Direction dig_dir = parse_direction(cmd->direction);
-            if (dig_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for DIG\n", cmd->direction);
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Invalid direction for DIG");
-                return -1;
-            }
-            
-            get_direction_offset(dig_dir, &dx, &dy);
-            result = field_create_object(&context->field, dx, dy, CELL_HOLE);
-            if (result == -6) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot dig hole at cell (%d, %d) - cell is occupied", target_x, target_y);
-                interpreter_set_warning(context, warning);
-            }
-            break;
-            
+        case CMD_DIG:   // Создание ямы в указанном направлении
         case CMD_MOUND: // Создание горы в указанном направлении
-            printf("MOUND %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
+        case CMD_GROW:  // Выращивание дерева в указанном направлении
+        case CMD_MAKE:  // Создание камня в указанном направлении
+        case CMD_CUT:   // Срубание дерева в указанном направлении
+        case CMD_PUSH:  // Толкание камня в указанном направлении
+            printf("%s %s\n", command_type_name(cmd->type), cmd->direction);
+            if (interpreter_require_dino(context, cmd->type) != 0) {
                 return -1;
             }
             
-            Direction mound_dir = parse_direction(cmd->direction);
-            if (mound_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for MOUND\n", cmd->direction);
+            Direction object_dir = parse_direction(cmd->direction);
+            if (object_dir == DIR_UNKNOWN) {
+                printf("Error: Invalid direction '%s' for %s\n", cmd->direction, command_type_name(cmd->type));
+                if (cmd->type == CMD_DIG) {
+                    context->error_occurred = 1;
+                    strcpy(context->error_message, "Invalid direction for DIG");
+                }
                 return -1;
             }
             
-            get_direction_offset(mound_dir, &dx, &dy);
-            result = field_create_object(&context->field, dx, dy, CELL_MOUNTAIN);
-            if (result == -6) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot create mountain at cell (%d, %d) - cell is occupied", target_x, target_y);
-                interpreter_set_warning(context, warning);
+            get_direction_offset(object_dir, &dx, &dy);
+            if (cmd->type == CMD_CUT) {
+                result = field_cut_tree(&context->field, dx, dy);
+            } else if (cmd->type == CMD_PUSH) {
+                result = field_push_stone(&context->field, dx, dy);
+            } else {
+                result = field_create_object(&context->field, dx, dy, interpreter_created_type(cmd->type));
             }
+            result = interpreter_check_field_result(context, cmd->type, result, dx, dy);
             break;
             
         case CMD_JUMP: // Прыжок динозавра на указанное расстояние в указанном направлении
             printf("JUMP %s %d\n", cmd->direction, cmd->n);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino not placed. Use START command first");
+            if (interpreter_require_dino(context, cmd->type) != 0) {
                 return -1;
             }
             
@@ -457,168 +1165,169 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
             }
             
             get_direction_offset(jump_dir, &dx, &dy);
-            result = field_jump_dino(&context->field, dx, dy, cmd->n);
-            
-            if (result == -4) {
-                context->error_occurred = 1;
-                strcpy(context->error_message, "Dino fell into a hole during jump!");
+            result = interpreter_check_field_result(context, cmd->type,
+                                                    field_jump_dino(&context->field, dx, dy, cmd->n), dx, dy);
+            if (context->error_occurred) {
                 return -1;
-            } else if (result == -5) {
-                interpreter_set_warning(context, "Jump blocked - obstacle right in front of dino");
-            } else if (result < -100) {
-                // Извлекаем координаты препятствия из кода ошибки
-                int error_code = -result - 100;
-                int blocked_x = error_code / 1000;
-                int blocked_y = error_code % 1000;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Jump blocked by obstacle at cell (%d, %d)", blocked_x, blocked_y);
-                interpreter_set_warning(context, warning);
-            } else if (result < 0) {
-                printf("Jump error: %s\n", field_get_error_message(result));
             }
             break;
             
-        case CMD_GROW: // Выращивание дерева в указанном направлении
-            printf("GROW %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                return -1;
+        case CMD_UNDO: // Откат последнего действия
+            printf("UNDO\n");
+            result = interpreter_undo(context);
+            if (result != 0) {
+                printf("Undo failed\n");
             }
+            break;
+            
+        case CMD_EXEC: // Выполнение команд из внешнего файла
+            printf("EXEC %s\n", cmd->filename);
+            result = interpreter_execute_file(context, cmd->filename);
+            if (result != 0) {
+                printf("EXEC failed for file: %s\n", cmd->filename);
+            }
+            break;
             
-            Direction grow_dir = parse_direction(cmd->direction);
-            if (grow_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for GROW\n", cmd->direction);
+        case CMD_LOAD: // Загрузка состояния поля из файла
+            printf("LOAD %s\n", cmd->filename);
+            if (context->field_initialized) {
+                printf("Error: LOAD can only be used as first command\n");
                 return -1;
             }
             
-            get_direction_offset(grow_dir, &dx, &dy);
-            result = field_create_object(&context->field, dx, dy, CELL_TREE);
-            if (result == -6) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot grow tree at cell (%d, %d) - cell is occupied", target_x, target_y);
-                interpreter_set_warning(context, warning);
+            result = field_load_from_file(&context->field, cmd->filename);
+            if (result == 0) {
+                context->field_initialized = 1;
+                if (context->field.dino_x != -1 && context->field.dino_y != -1) {
+                    context->dino_placed = 1;
+                }
+            } else {
+                printf("LOAD failed for file: %s\n", cmd->filename);
             }
             break;
             
-        case CMD_CUT: // Срубание дерева в указанном направлении
-            printf("CUT %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                return -1;
+        case CMD_IF: // Условное выполнение команды
+            if (cmd->condition == IF_NEAREST) {
+                printf("IF NEAREST %c WITHIN %d THEN %s\n", cmd->color, cmd->n, cmd->then_command);
+            } else if (cmd->condition == IF_COUNT) {
+                printf("IF COUNT %d %d %d %d OF %c %c %d THEN %s\n", cmd->x, cmd->y, cmd->x2, cmd->y2,
+                       cmd->color, cmd->compare, cmd->n, cmd->then_command);
+            } else {
+                printf("IF CELL %d %d IS %c THEN %s\n", cmd->x, cmd->y, cmd->color, cmd->then_command);
             }
+            result = interpreter_execute_if_command(context, cmd, line_number);
+            break;
             
-            Direction cut_dir = parse_direction(cmd->direction);
-            if (cut_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for CUT\n", cmd->direction);
+        case CMD_GOTO: // Перемещение динозавра к клетке кратчайшим путем
+            printf("GOTO %d %d\n", cmd->x, cmd->y);
+            if (interpreter_require_dino(context, cmd->type) != 0) {
                 return -1;
             }
             
-            get_direction_offset(cut_dir, &dx, &dy);
-            result = field_cut_tree(&context->field, dx, dy);
-            if (result == -7) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
+            if (context->path_cache == NULL) {
+                context->path_cache = path_cache_create();
+                if (context->path_cache == NULL) {
+                    context->error_occurred = 1;
+                    strcpy(context->error_message, "Cannot allocate path cache");
+                    return -1;
+                }
+            }
+            
+            result = path_goto(context->path_cache, &context->field, cmd->x, cmd->y);
+            if (result == -11) {
                 char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot cut at cell (%d, %d) - no tree found", target_x, target_y);
+                snprintf(warning, sizeof(warning), "No path to cell (%d, %d)", cmd->x, cmd->y);
                 interpreter_set_warning(context, warning);
             } else if (result < 0) {
-                printf("Cut error: %s\n", field_get_error_message(result));
+                printf("GOTO error: %s\n", field_get_error_message(result));
+            } else {
+                result = 0;
             }
             break;
             
-        case CMD_MAKE: // Создание камня в указанном направлении
-            printf("MAKE %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
+        case CMD_TICK: // Поколения клеточного автомата по таблице правил
+            printf("TICK %d\n", cmd->n);
+            if (!context->field_initialized) {
+                printf("Error: Field not initialized for TICK\n");
                 return -1;
             }
-            
-            Direction make_dir = parse_direction(cmd->direction);
-            if (make_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for MAKE\n", cmd->direction);
+            if (cmd->n <= 0) {
+                printf("Error: TICK requires a positive number of generations\n");
                 return -1;
             }
             
-            get_direction_offset(make_dir, &dx, &dy);
-            result = field_create_object(&context->field, dx, dy, CELL_STONE);
-            if (result == -6) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot create stone at cell (%d, %d) - cell is occupied", target_x, target_y);
-                interpreter_set_warning(context, warning);
+            long changed = automaton_run(&context->automaton, &context->automaton_pool, &context->field, cmd->n);
+            if (changed < 0) {
+                return -1;
             }
+            printf("World advanced %d generations: %ld cells changed\n", cmd->n, changed);
             break;
             
-        case CMD_PUSH: // Толкание камня в указанном направлении
-            printf("PUSH %s\n", cmd->direction);
-            if (!context->dino_placed) {
-                printf("Error: Dino not placed. Use START command first\n");
-                return -1;
+        case CMD_FILL:    // Заливка области объектом или цветом
+        case CMD_CLEAR:   // Очистка области
+        case CMD_REPLACE: // Замена символа в области
+            if (cmd->type == CMD_FILL) {
+                printf("FILL %d %d %d %d %c\n", cmd->x, cmd->y, cmd->x2, cmd->y2, cmd->color);
+            } else if (cmd->type == CMD_CLEAR) {
+                printf("CLEAR %d %d %d %d\n", cmd->x, cmd->y, cmd->x2, cmd->y2);
+            } else {
+                printf("REPLACE %c WITH %c IN %d %d %d %d\n", cmd->color, cmd->replacement,
+                       cmd->x, cmd->y, cmd->x2, cmd->y2);
             }
-            
-            Direction push_dir = parse_direction(cmd->direction);
-            if (push_dir == DIR_UNKNOWN) {
-                printf("Error: Invalid direction '%s' for PUSH\n", cmd->direction);
+            if (!context->field_initialized) {
+                printf("Error: Field not initialized for %s\n", command_type_name(cmd->type));
                 return -1;
             }
             
-            get_direction_offset(push_dir, &dx, &dy);
-            result = field_push_stone(&context->field, dx, dy);
-            if (result == -8) {
-                int target_x = (context->field.dino_x + dx + context->field.width) % context->field.width;
-                int target_y = (context->field.dino_y + dy + context->field.height) % context->field.height;
-                char warning[100];
-                snprintf(warning, sizeof(warning), "Cannot push at cell (%d, %d) - no stone found", target_x, target_y);
-                interpreter_set_warning(context, warning);
-            } else if (result == -9) {
-                interpreter_set_warning(context, "Stone push blocked by obstacle");
-            } else if (result == -10) {
-                interpreter_set_warning(context, "Stone hit tree and bounced back!");
-            } else if (result < 0) {
-                printf("Push error: %s\n", field_get_error_message(result));
+            // Одна команда - один уровень отката, клетка динозавра не меняется
+            if (cmd->type == CMD_FILL) {
+                result = field_fill_region(&context->field, cmd->x, cmd->y, cmd->x2, cmd->y2, cmd->color);
+            } else if (cmd->type == CMD_CLEAR) {
+                result = field_clear_region(&context->field, cmd->x, cmd->y, cmd->x2, cmd->y2);
+            } else {
+                result = field_replace_region(&context->field, cmd->x, cmd->y, cmd->x2, cmd->y2,
+                                              cmd->color, cmd->replacement);
             }
-            break;
-            
-        case CMD_UNDO: // Откат последнего действия
-            printf("UNDO\n");
-            result = interpreter_undo(context);
-            if (result != 0) {
-                printf("Undo failed\n");
+            if (result < 0) {
+                printf("%s error: %s\n", command_type_name(cmd->type), field_get_error_message(result));
+                return -1;
             }
-            break;
             
-        case CMD_EXEC: // Выполнение команд из внешнего файла
-            printf("EXEC %s\n", cmd->filename);
-            result = interpreter_execute_file(context, cmd->filename);
-            if (result != 0) {
-                printf("EXEC failed for file: %s\n", cmd->filename);
+            if (cmd->type == CMD_FILL) {
+                printf("Filled %d cells with '%c'\n", result, cmd->color);
+            } else if (cmd->type == CMD_CLEAR) {
+                printf("Cleared %d cells\n", result);
+            } else {
+                printf("Replaced %d cells\n", result);
             }
+            result = 0;
             break;
             
-        case CMD_LOAD: // Загрузка состояния поля из файла
-            printf("LOAD %s\n", cmd->filename);
-            if (context->field_initialized) {
-                printf("Error: LOAD can only be used as first command\n");
+        case CMD_STAMP: // Вставка шаблона из файла (один уровень отката)
+            printf("STAMP %s %d %d\n", cmd->filename, cmd->x, cmd->y);
+            if (!context->field_initialized) {
+                printf("Error: Field not initialized for STAMP\n");
                 return -1;
             }
             
-            result = field_load_from_file(&context->field, cmd->filename);
-            if (result == 0) {
-                context->field_initialized = 1;
-                if (context->field.dino_x != -1 && context->field.dino_y != -1) {
-                    context->dino_placed = 1;
+            if (context->pattern_cache == NULL) {
+                context->pattern_cache = pattern_cache_create();
+                if (context->pattern_cache == NULL) {
+                    context->error_occurred = 1;
+                    strcpy(context->error_message, "Cannot allocate pattern cache");
+                    return -1;
                 }
-            } else {
-                printf("LOAD failed for file: %s\n", cmd->filename);
             }
-            break;
             
-        case CMD_IF: // Условное выполнение команды
-            printf("IF CELL %d %d IS %c THEN %s\n", cmd->x, cmd->y, cmd->color, cmd->then_command);
-            result = interpreter_execute_if_command(context, cmd, line_number);
+            const Pattern* pattern = pattern_cache_get(context->pattern_cache, cmd->filename);
+            result = (pattern != NULL) ? pattern_stamp(pattern, &context->field, cmd->x, cmd->y) : -1;
+            if (result < 0) {
+                printf("STAMP failed for file: %s\n", cmd->filename);
+                return -1;
+            }
+            
+            printf("Stamped %dx%d pattern: %d cells written\n", pattern->width, pattern->height, result);
+            result = 0;
             break;
             
         default:
@@ -626,16 +1335,6 @@ int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd,
             break;
     }
     
-    // Отображение состояния после команды (если включена визуализация)
-    if (context->display_enabled && !context->error_occurred) {
-        clear_screen();
-        field_display(&context->field);
-        interpreter_show_warnings(context);  // Предупреждения после поля
-        wait_for_display(context->display_interval);
-    } else if (context->has_warning) {
-        // Если визуализация отключена, всё равно показываются предупреждения
-        interpreter_show_warnings(context);
-    }
-    
+    interpreter_end_command(context);
     return result;
 }
\ No newline at end of file
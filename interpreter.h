@@ -3,8 +3,18 @@
 
 #include "field.h"
 #include "parser.h"
+#include "stats.h"
+#include "trace.h"
+#include "profile.h"
+#include "pathfind.h"
+#include "scriptcache.h"
+#include "memo.h"
+#include "automaton.h"
+#include "pattern.h"
+#include "liveview.h"
 
 #define MAX_UNDO_LEVELS 20  // Максимальное количество уровней отката
+#define MAX_EXEC_DEPTH 10   // Максимальная вложенность EXEC
 
 // Контекст интерпретатора - хранит состояние выполнения программы
 typedef struct {
@@ -18,7 +28,9 @@ typedef struct {
     double display_interval;        // Интервал между отображениями
     
     // UNDO - система отката действий
-    Field history[MAX_UNDO_LEVELS]; // История состояний поля
+    Field* history;                 // Снимки поля (MAX_UNDO_LEVELS, выделяются при первом сохранении)
+    int history_slots[MAX_UNDO_LEVELS]; // Снимок каждого уровня истории (одинаковые уровни делят снимок)
+    int history_refs[MAX_UNDO_LEVELS];  // Сколько уровней ссылается на снимок
     int history_size;               // Текущий размер истории
     int current_history_index;      // Текущий индекс в истории
     
@@ -30,19 +42,113 @@ typedef struct {
     char current_filename[256];     // Текущий исполняемый файл
     int exec_depth;                 // Глубина вложенности EXEC (защита от бесконечной рекурсии)
     
+    // Замеры производительности (--timing)
+    int timing_enabled;             // Включен ли замер времени разбора
+    long commands_executed;         // Количество выполненных команд (включая вложенные)
+    double parse_time;              // Суммарное время разбора строк в секундах
+    
+    // Статистика выполнения (--stats)
+    ExecutionStats stats;           // Счетчики и гистограммы по типам команд
+    int command_warned;             // Было ли предупреждение у текущей команды
+    double display_time;            // Время отображения (исключается из задержек команд)
+    
+    // Трассировка (--trace-events)
+    TraceBuffer trace;              // Буфер событий трассы
+    
+    // Профиль по строкам скриптов (--profile)
+    Profiler profile;               // Счетчики и время по (файл, строка)
+    
+    // Поиск пути (GOTO)
+    PathCache* path_cache;          // Кэш полей расстояний (создается при первом GOTO)
+    
+    // Разобранные файлы EXEC (--serve)
+    ScriptCache* script_cache;      // NULL - файлы читаются и разбираются при каждом EXEC
+    
+    // Шаблоны STAMP
+    PatternCache* pattern_cache;    // Разобранные файлы шаблонов (создается при первом STAMP)
+    
+    // Правила клеточного автомата (TICK, --rules)
+    AutomatonRules automaton;
+    AutomatonPool* automaton_pool;  // Потоки TICK (создаются при первом многопоточном TICK)
+    
+    // Результаты EXEC (--memo-exec)
+    ExecMemo* exec_memo;            // NULL - каждый EXEC выполняется заново
+    
+    // Публикация поля в разделяемую память (--live)
+    LiveView* live_view;            // NULL - кадры не публикуются
+    
 } InterpreterContext;
 
+// Замер одной команды для --stats/--trace-events
+typedef struct {
+    int outer_warned;               // Предупреждение внешней команды (EXEC, THEN)
+    double display_before;          // Время отображения до начала команды
+    double start;
+} CommandTiming;
+
+// Кадр выполняемого файла: основной скрипт или файл EXEC
+typedef struct {
+    char filename[256];
+    FILE* file;                     // Построчное чтение файла
+    ParsedScript* script;           // Или разобранный файл (закреплен, пока кадр на стеке)
+    int next_line;                  // Индекс следующей строки script
+    int line_number;                // Номер текущей строки
+    char line[MAX_LINE_LENGTH];     // Текст текущей строки, прочитанной из file
+    int top_level;                  // Основной скрипт: сообщения без имени файла, без входа/выхода
+    int result;                     // Результат последней команды файла
+    int profile_index;
+    double start;                   // Начало выполнения файла (для трассы)
+    
+    // EXEC, запустивший файл (завершается при снятии кадра)
+    char saved_filename[256];       // Имя файла до EXEC
+    int exec_line;                  // Номер строки EXEC в родительском кадре
+    CommandTiming exec_timing;
+    ProfileMark exec_mark;
+} ExecFrame;
+
+// Состояние пошагового выполнения: стек кадров вместо рекурсии EXEC
+typedef struct {
+    ExecFrame frames[MAX_EXEC_DEPTH + 1];
+    int depth;                      // Кадров на стеке; 0 - выполнение закончено
+    int result;                     // Результат последней команды нижнего кадра
+} ExecState;
+
 // Функции интерпретатора
 void interpreter_init(InterpreterContext* context); // инициализация контекста интерпретатора (обнуление, выделение памяти)
+void interpreter_reset(InterpreterContext* context); // сброс для следующего задания с сохранением выделенной памяти
+void interpreter_free(InterpreterContext* context); // освобождение истории, кэшей, потоков TICK, трассы и профиля
 int interpreter_execute_command(InterpreterContext* context, ParsedCommand* cmd, int line_number); // выполнение одной команды (cmd - распознанная команда, line_number - для кодов ошибок)
 int interpreter_execute_file(InterpreterContext* context, const char* filename); // выполнение всех команд из файла (команда EXEC)
+int interpreter_execute_parsed(InterpreterContext* context, ParsedScript* script); // выполнение разобранного основного скрипта (--serve)
 int interpreter_execute_if_command(InterpreterContext* context, ParsedCommand* cmd, int line_number); // обработка условной команды IF
 void interpreter_save_state(InterpreterContext* context);
 int interpreter_undo(InterpreterContext* context);
 void interpreter_set_display_options(InterpreterContext* context, int enabled, double interval); // настройки отображения
 void interpreter_set_save_option(InterpreterContext* context, int enabled); // вкл/выкл сохранение результата в файл
+void interpreter_set_timing_option(InterpreterContext* context, int enabled); // вкл/выкл замер времени разбора
+void interpreter_set_stats_option(InterpreterContext* context, int enabled); // вкл/выкл сбор статистики по командам
+int interpreter_set_trace_option(InterpreterContext* context, long capacity); // вкл трассировку с буфером на capacity событий
+void interpreter_set_profile_option(InterpreterContext* context, int enabled); // вкл/выкл профиль по строкам
+int interpreter_set_memo_option(InterpreterContext* context, int enabled); // вкл/выкл кэш результатов EXEC
+int interpreter_set_live_option(InterpreterContext* context, const char* name); // публикация поля в разделяемой памяти name
+int interpreter_parse_line(InterpreterContext* context, const char* line, ParsedCommand* cmd); // parse_line с учетом времени разбора
+FILE* interpreter_open_script(InterpreterContext* context, const char* filename); // fopen с отметкой в трассе
 const char* interpreter_get_error_message(InterpreterContext* context);
 
+// Пошаговое выполнение (планировщик сессий): выполнение можно прервать после любой команды
+int interpreter_start_file(InterpreterContext* context, ExecState* state, const char* filename); // основной скрипт; -3, если файл не открывается
+void interpreter_start_parsed(InterpreterContext* context, ExecState* state, ParsedScript* script); // основной скрипт уже разобран
+long interpreter_step(InterpreterContext* context, ExecState* state, long quota); // не больше quota строк; возвращает число выполненных
+int interpreter_run(InterpreterContext* context, ExecState* state); // выполнение до конца; результат последней команды
+
+// Шаги выполнения команды (общие для интерпретатора и скриптов, скомпилированных --emit-c)
+int interpreter_begin_command(InterpreterContext* context, CommandType type, int line_number, const char* echo); // вывод строки команды и сохранение состояния
+int interpreter_require_dino(InterpreterContext* context, CommandType type); // 0, если динозавр размещен
+int interpreter_check_field_result(InterpreterContext* context, CommandType type, int result, int dx, int dy); // предупреждения/ошибки по коду field_*
+void interpreter_end_command(InterpreterContext* context); // отображение поля и предупреждений
+int interpreter_enter_file(InterpreterContext* context, const char* filename, char* saved_filename); // вход в файл EXEC
+void interpreter_leave_file(InterpreterContext* context, const char* filename, const char* saved_filename); // выход из файла EXEC
+
 // Функции для работы с предупреждениями
 void interpreter_set_warning(InterpreterContext* context, const char* warning);
 void interpreter_show_warnings(InterpreterContext* context);
@@ -0,0 +1,185 @@
+#include "liveview.h"
+#include "utils.h"
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Имя объекта разделяемой памяти начинается с '/'
+static void liveview_object_name(const char* name, char* out, size_t size) {
+    snprintf(out, size, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+LiveView* liveview_create(const char* name) {
+    LiveView* view = calloc(1, sizeof(LiveView));
+    if (view == NULL) {
+        printf("Error: Cannot allocate live view\n");
+        return NULL;
+    }
+    liveview_object_name(name, view->name, sizeof(view->name));
+
+    int fd = shm_open(view->name, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Error: Cannot create shared memory '%s'\n", view->name);
+        free(view);
+        return NULL;
+    }
+    if (ftruncate(fd, sizeof(LiveViewFrame)) != 0) {
+        printf("Error: Cannot resize shared memory '%s'\n", view->name);
+        close(fd);
+        shm_unlink(view->name);
+        free(view);
+        return NULL;
+    }
+    void* memory = mmap(NULL, sizeof(LiveViewFrame), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        printf("Error: Cannot map shared memory '%s'\n", view->name);
+        shm_unlink(view->name);
+        free(view);
+        return NULL;
+    }
+
+    // Сегмент после ftruncate заполнен нулями: кадров нет, sequence четный
+    view->shared = memory;
+    view->shared->version = LIVEVIEW_VERSION;
+    view->shared->dino_x = -1;
+    view->shared->dino_y = -1;
+    atomic_thread_fence(memory_order_release);
+    view->shared->magic = LIVEVIEW_MAGIC;
+    return view;
+}
+
+// Начало и конец записи кадра: между ними sequence нечетный
+static uint64_t liveview_write_begin(LiveViewFrame* shared) {
+    uint64_t sequence = atomic_load_explicit(&shared->sequence, memory_order_relaxed);
+    atomic_store_explicit(&shared->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    return sequence;
+}
+
+static void liveview_write_end(LiveViewFrame* shared, uint64_t sequence) {
+    atomic_store_explicit(&shared->sequence, sequence + 2, memory_order_release);
+}
+
+// Публикация кадра, если поле или положение динозавра изменились с прошлого кадра.
+// Проверка по хешу поля, поэтому команды без изменений стоят одно сравнение.
+// Без force кадры чаще LIVEVIEW_MIN_PERIOD пропускаются
+void liveview_publish(LiveView* view, const Field* field, long commands, int force) {
+    LiveViewFrame* shared = view->shared;
+    if (shared->frame != 0 && field->hash == view->published_hash &&
+        field->width == view->published_width && field->height == view->published_height &&
+        field->dino_x == view->published_dino_x && field->dino_y == view->published_dino_y) {
+        return;
+    }
+    double now = get_time_seconds();
+    if (!force && shared->frame != 0 && now - view->published_time < LIVEVIEW_MIN_PERIOD) {
+        return;
+    }
+    view->published_time = now;
+
+    uint64_t sequence = liveview_write_begin(shared);
+    shared->frame++;
+    shared->commands = (uint64_t)commands;
+    shared->hash = field->hash;
+    shared->width = field->width;
+    shared->height = field->height;
+    shared->dino_x = field->dino_x;
+    shared->dino_y = field->dino_y;
+    shared->length = field_render(field, shared->cells);
+    liveview_write_end(shared, sequence);
+
+    view->published_hash = field->hash;
+    view->published_width = field->width;
+    view->published_height = field->height;
+    view->published_dino_x = field->dino_x;
+    view->published_dino_y = field->dino_y;
+}
+
+// Отметка о завершении и удаление сегмента (подключенные читатели сохраняют отображение)
+void liveview_destroy(LiveView* view) {
+    if (view == NULL) return;
+
+    uint64_t sequence = liveview_write_begin(view->shared);
+    view->shared->finished = 1;
+    liveview_write_end(view->shared, sequence);
+
+    munmap(view->shared, sizeof(LiveViewFrame));
+    shm_unlink(view->name);
+    free(view);
+}
+
+// Согласованная копия кадра: чтение повторяется, пока писатель не закончит запись
+static void liveview_read(const LiveViewFrame* shared, LiveViewFrame* copy) {
+    for (;;) {
+        uint64_t before = atomic_load_explicit((_Atomic uint64_t*)&shared->sequence, memory_order_acquire);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(copy, shared, sizeof(LiveViewFrame));
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = atomic_load_explicit((_Atomic uint64_t*)&shared->sequence, memory_order_relaxed);
+        if (before == after) {
+            return;
+        }
+    }
+}
+
+// Читатель (--view): вывод каждого нового кадра, пока выполнение не завершится.
+// Кадры между опросами (раз в interval секунд) пропускаются
+int liveview_watch(const char* name, double interval) {
+    char object_name[256];
+    liveview_object_name(name, object_name, sizeof(object_name));
+
+    int fd = shm_open(object_name, O_RDONLY, 0);
+    if (fd < 0) {
+        printf("Error: Cannot open shared memory '%s'\n", object_name);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(LiveViewFrame)) {
+        printf("Error: Shared memory '%s' is not a dino live view\n", object_name);
+        close(fd);
+        return -1;
+    }
+    const LiveViewFrame* shared = mmap(NULL, sizeof(LiveViewFrame), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (shared == MAP_FAILED) {
+        printf("Error: Cannot map shared memory '%s'\n", object_name);
+        return -1;
+    }
+
+    static LiveViewFrame copy;
+    int result = 0;
+    uint64_t shown = 0;
+    for (;;) {
+        liveview_read(shared, &copy);
+        if (copy.magic == 0) {
+            usleep((useconds_t)(interval * 1000000));  // Сегмент создан, но еще не заполнен
+            continue;
+        }
+        if (copy.magic != LIVEVIEW_MAGIC || copy.version != LIVEVIEW_VERSION) {
+            printf("Error: Shared memory '%s' is not a dino live view\n", object_name);
+            result = -1;
+            break;
+        }
+        if (copy.frame != shown && copy.length > 0 && copy.length <= (int32_t)sizeof(copy.cells)) {
+            shown = copy.frame;
+            printf("Frame %llu: %llu commands, %dx%d, dino at (%d, %d)\n",
+                   (unsigned long long)copy.frame, (unsigned long long)copy.commands,
+                   copy.width, copy.height, copy.dino_x, copy.dino_y);
+            fwrite(copy.cells, 1, copy.length, stdout);
+            fflush(stdout);
+        }
+        if (copy.finished) {
+            printf("Live view finished after %llu frames\n", (unsigned long long)copy.frame);
+            break;
+        }
+        usleep((useconds_t)(interval * 1000000));
+    }
+
+    munmap((void*)shared, sizeof(LiveViewFrame));
+    return result;
+}
@@ -0,0 +1,61 @@
+#ifndef LIVEVIEW_H
+#define LIVEVIEW_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "field.h"
+
+// Публикация поля для внешних наблюдателей (--live NAME): после команды,
+// изменившей поле или положение динозавра, кадр записывается в разделяемую
+// память POSIX (shm_open NAME), но не чаще раза в LIVEVIEW_MIN_PERIOD секунд;
+// последнее состояние публикуется при завершении. Запись под seqlock: интерпретатор
+// никогда не ждет читателей, читатель повторяет чтение, если кадр менялся во время
+// копирования.
+//
+// Чтение согласованного кадра:
+//   1. s1 = sequence (acquire); нечетное значение - идет запись, повторить
+//   2. скопировать нужные поля сегмента
+//   3. барьер acquire, s2 = sequence; s1 != s2 - кадр изменился, повторить
+//
+// Сегмент удаляется (shm_unlink) при завершении; уже подключенные читатели
+// видят последний кадр с finished = 1. Пример читателя - dino --view NAME
+
+#define LIVEVIEW_MAGIC 0x564C4E44u     // "DNLV"
+#define LIVEVIEW_VERSION 1
+#define LIVEVIEW_MIN_PERIOD 0.001      // Не больше 1000 кадров в секунду
+
+// Раскладка сегмента (общая для писателя и читателей)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    _Atomic uint64_t sequence;  // Счетчик seqlock: нечетный во время записи кадра
+    uint64_t frame;             // Номер кадра (растет на 1 с каждой публикацией)
+    uint64_t commands;          // Выполнено команд к моменту кадра
+    uint64_t hash;              // Хеш Зобриста поля
+    int32_t width;
+    int32_t height;
+    int32_t dino_x;             // -1, если динозавр не поставлен
+    int32_t dino_y;
+    int32_t finished;           // 1 - выполнение завершено, кадров больше не будет
+    int32_t length;             // Длина текста поля в cells
+    char cells[FIELD_RENDER_BUFFER_SIZE];  // Поле как в файле: height строк по width символов с '\n'
+} LiveViewFrame;
+
+typedef struct {
+    char name[256];
+    LiveViewFrame* shared;
+    uint64_t published_hash;    // Поле последнего кадра (повторные кадры не публикуются)
+    int published_width;
+    int published_height;
+    int published_dino_x;
+    int published_dino_y;
+    double published_time;      // Время последней публикации (get_time_seconds)
+} LiveView;
+
+// Функции публикации
+LiveView* liveview_create(const char* name);
+void liveview_publish(LiveView* view, const Field* field, long commands, int force);
+void liveview_destroy(LiveView* view);
+int liveview_watch(const char* name, double interval);
+
+#endif
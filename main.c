@@ -5,17 +5,139 @@
 #include "parser.h"
 #include "interpreter.h"
 #include "utils.h"
+#include "heatmap.h"
+#include "counts.h"
+#include "crowd.h"
+#include "emitc.h"
+#include "serve.h"
+#include "solve.h"
+#include "liveview.h"
+#include "scheduler.h"
+#include "watch.h"
+#include <unistd.h>
 
 // Вывод справки по использованию программы
 void print_usage(const char* program_name) {
     printf("Usage: %s input.txt output.txt [options]\n", program_name);
+    printf("       %s --serve socket.sock [--threads N]\n", program_name);
+    printf("       %s --view NAME [--interval N]\n", program_name);
+    printf("       %s --watch script.txt [output.txt] [--checkpoint N] [--interval N]\n", program_name);
+    printf("       %s --solve start.txt target.txt [script.txt] [--threads N] [--memory MB] [--commands LIST]\n",
+           program_name);
     printf("Options:\n");
     printf("  --interval N    Set display interval in seconds (default: 1.0)\n");
     printf("  --no-display    Disable console visualization\n");
     printf("  --no-save       Disable saving final state to output file\n");
+    printf("  --rle           Save final state in run-length encoded format\n");
+    printf("  --timing        Print parse/execute/output time split at exit\n");
+    printf("  --stats         Print per-command execution statistics at exit\n");
+    printf("  --stats-json F  Also write the statistics as JSON to file F\n");
+    printf("  --trace-events F  Write Chrome/Perfetto trace-event JSON to file F\n");
+    printf("  --profile       Print hottest script lines and write annotated <script>.prof files\n");
+    printf("  --rules F       Load the TICK cellular-automaton rule table from F\n");
+    printf("  --memo-exec     Reuse results of EXEC files on repeated field states\n");
+    printf("  --live NAME     Publish the field after every command to POSIX shared memory NAME (read with --view)\n");
+    printf("  --heatmap F     Write per-cell activity counters to F (.pgm images or .csv)\n");
+    printf("  --crowd         Treat input as a crowd description (SIZE/LOAD + DINO x y script lines)\n");
+    printf("  --threads N     Worker threads for --crowd, --solve and TICK, worker processes for --serve (default: number of CPUs)\n");
+    printf("  --ticks N       Stop --crowd after N ticks (default: until all scripts finish)\n");
+    printf("  --emit-c        Translate the input script (EXEC files inlined) to C source in output file\n");
+    printf("  --native        Treat input as a shared object built from --emit-c output\n");
+    printf("  --sessions      Treat input as a session list (SESSION script [count]); run them interleaved\n");
+    printf("  --quota N       Script lines per session time slice for --sessions (default: %d)\n", SCHEDULER_DEFAULT_QUOTA);
+    printf("  --serve S       Accept jobs over Unix socket S (see serve.h for the protocol)\n");
     printf("  --help          Show this help message\n");
 }
 
+// Сохранение конечного состояния поля в выходной файл
+static void save_final_state(Field* field, const char* output_filename, int rle) {
+    FILE* output_file = fopen(output_filename, "w");
+    if (output_file != NULL) {
+        if (rle) {
+            field_print_rle(field, output_file);
+        } else {
+            field_print(field, output_file);
+        }
+        fclose(output_file);
+        printf("Final state saved to '%s'\n", output_filename);
+    } else {
+        printf("Error: Cannot create output file '%s'\n", output_filename);
+    }
+}
+
+// Выполнение толпы динозавров (--crowd): 0 при успехе
+static int run_crowd(Field* field, const char* input_filename, int threads, long max_ticks) {
+    Crowd* crowd = crowd_create(field, threads);
+    if (crowd == NULL) {
+        return -1;
+    }
+    
+    int result = crowd_load(crowd, input_filename);
+    if (result == 0) {
+        double start = get_time_seconds();
+        long ticks = crowd_run(crowd, max_ticks);
+        double elapsed = get_time_seconds() - start;
+        
+        crowd_print_summary(crowd, stdout);
+        printf("Crowd time: %.3f s (%.0f ticks/s)\n", elapsed, elapsed > 0 ? ticks / elapsed : 0.0);
+        if (ticks < 0) {
+            result = -1;
+        }
+    }
+    
+    crowd_destroy(crowd);
+    return result;
+}
+
+// Выполнение сессий (--sessions): 0, если все сессии завершились без ошибок
+static int run_sessions(const char* input_filename, const char* output_filename, int rle, long quota) {
+    Scheduler* scheduler = scheduler_create(quota);
+    if (scheduler == NULL) {
+        return -1;
+    }
+    
+    int result = scheduler_load(scheduler, input_filename);
+    if (result == 0) {
+        double start = get_time_seconds();
+        long lines = scheduler_run(scheduler);
+        double elapsed = get_time_seconds() - start;
+        
+        scheduler_print_summary(scheduler, stdout);
+        printf("Sessions time: %.3f s (%.0f lines/s)\n", elapsed, elapsed > 0 ? lines / elapsed : 0.0);
+        
+        if (output_filename != NULL) {
+            FILE* output_file = fopen(output_filename, "w");
+            if (output_file != NULL) {
+                scheduler_print_fields(scheduler, output_file, rle);
+                fclose(output_file);
+                printf("Final states saved to '%s'\n", output_filename);
+            } else {
+                printf("Error: Cannot create output file '%s'\n", output_filename);
+            }
+        }
+        
+        for (int i = 0; i < scheduler->count; i++) {
+            if (lines < 0 || scheduler->sessions[i].context->error_occurred) {
+                result = -1;
+            }
+        }
+    }
+    
+    scheduler_destroy(scheduler);
+    return result;
+}
+
+// Выполнение скрипта: 0 при успехе, -1 если файл не открывается
+static int run_script(InterpreterContext* context, const char* input_filename) {
+    ExecState state;
+    if (interpreter_start_file(context, &state, input_filename) != 0) {
+        printf("Error: Cannot open input file '%s'\n", input_filename);
+        return -1;
+    }
+    interpreter_run(context, &state);
+    return 0;
+}
+
 // Главная функция программы
 int main(int argc, char* argv[]) {
     // Проверка минимального количества аргументов
@@ -24,6 +146,83 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Режим сервера: dino --serve socket.sock [--threads N]
+    if (strcmp(argv[1], "--serve") == 0) {
+        int workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if (argc == 5 && strcmp(argv[3], "--threads") == 0) {
+            workers = atoi(argv[4]);
+        } else if (argc != 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return serve_run(argv[2], workers) == 0 ? 0 : 1;
+    }
+    
+    // Наблюдатель: dino --view NAME [--interval N] - кадры из сегмента --live
+    if (strcmp(argv[1], "--view") == 0) {
+        double interval = 0.1;
+        if (argc == 5 && strcmp(argv[3], "--interval") == 0) {
+            interval = atof(argv[4]);
+        } else if (argc != 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return liveview_watch(argv[2], interval) == 0 ? 0 : 1;
+    }
+    
+    // Наблюдение: dino --watch script.txt [output.txt] [опции] - повтор после изменений
+    if (strcmp(argv[1], "--watch") == 0) {
+        if (argc < 3) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* output_filename = NULL;
+        long checkpoint_lines = WATCH_DEFAULT_CHECKPOINT;
+        double interval = WATCH_DEFAULT_INTERVAL;
+        for (int i = 3; i < argc; i++) {
+            if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc) {
+                checkpoint_lines = atol(argv[++i]);
+            } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+                interval = atof(argv[++i]);
+            } else if (i == 3 && argv[i][0] != '-') {
+                output_filename = argv[i];
+            } else {
+                printf("Unknown option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        return watch_run(argv[2], output_filename, checkpoint_lines, interval) == 0 ? 0 : 1;
+    }
+    
+    // Поиск скрипта: dino --solve start.txt target.txt [script.txt] [опции]
+    if (strcmp(argv[1], "--solve") == 0) {
+        if (argc < 4) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        const char* script_filename = NULL;
+        const char* commands = NULL;
+        int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        long memory_mb = SOLVE_DEFAULT_MEMORY_MB;
+        for (int i = 4; i < argc; i++) {
+            if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threads = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+                memory_mb = atol(argv[++i]);
+            } else if (strcmp(argv[i], "--commands") == 0 && i + 1 < argc) {
+                commands = argv[++i];
+            } else if (i == 4 && argv[i][0] != '-') {
+                script_filename = argv[i];
+            } else {
+                printf("Unknown option: %s\n", argv[i]);
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        return solve_run(argv[2], argv[3], script_filename, threads, memory_mb, commands) == 0 ? 0 : 1;
+    }
+    
     // Обработка аргументов командной строки
     char* input_filename = argv[1];
     char* output_filename = argv[2];
@@ -31,6 +230,23 @@ int main(int argc, char* argv[]) {
     // Параметры по умолчанию
     int display_enabled = 1;
     int save_enabled = 1;
+    int save_rle = 0;
+    int timing_enabled = 0;
+    int stats_enabled = 0;
+    char* stats_json_filename = NULL;
+    char* trace_filename = NULL;
+    int profile_enabled = 0;
+    int memo_enabled = 0;
+    char* rules_filename = NULL;
+    char* live_name = NULL;
+    char* heatmap_filename = NULL;
+    int crowd_enabled = 0;
+    int emit_c = 0;
+    int native_enabled = 0;
+    int sessions_enabled = 0;
+    long session_quota = SCHEDULER_DEFAULT_QUOTA;
+    int crowd_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long crowd_ticks = 0;
     double display_interval = 1.0;
     
     // Разбор дополнительных опций
@@ -39,6 +255,41 @@ int main(int argc, char* argv[]) {
             display_enabled = 0;
         } else if (strcmp(argv[i], "--no-save") == 0) {
             save_enabled = 0;
+        } else if (strcmp(argv[i], "--rle") == 0) {
+            save_rle = 1;
+        } else if (strcmp(argv[i], "--timing") == 0) {
+            timing_enabled = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats_enabled = 1;
+        } else if (strcmp(argv[i], "--stats-json") == 0 && i + 1 < argc) {
+            stats_enabled = 1;
+            stats_json_filename = argv[++i];
+        } else if (strcmp(argv[i], "--trace-events") == 0 && i + 1 < argc) {
+            trace_filename = argv[++i];
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profile_enabled = 1;
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rules_filename = argv[++i];
+        } else if (strcmp(argv[i], "--memo-exec") == 0) {
+            memo_enabled = 1;
+        } else if (strcmp(argv[i], "--live") == 0 && i + 1 < argc) {
+            live_name = argv[++i];
+        } else if (strcmp(argv[i], "--heatmap") == 0 && i + 1 < argc) {
+            heatmap_filename = argv[++i];
+        } else if (strcmp(argv[i], "--crowd") == 0) {
+            crowd_enabled = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            crowd_threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            crowd_ticks = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--emit-c") == 0) {
+            emit_c = 1;
+        } else if (strcmp(argv[i], "--native") == 0) {
+            native_enabled = 1;
+        } else if (strcmp(argv[i], "--sessions") == 0) {
+            sessions_enabled = 1;
+        } else if (strcmp(argv[i], "--quota") == 0 && i + 1 < argc) {
+            session_quota = atol(argv[++i]);
         } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
             display_interval = atof(argv[++i]);
         } else if (strcmp(argv[i], "--help") == 0) {
@@ -57,61 +308,145 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Трансляция скрипта в C вместо выполнения
+    if (emit_c) {
+        FILE* c_file = fopen(output_filename, "w");
+        if (c_file == NULL) {
+            printf("Error: Cannot create output file '%s'\n", output_filename);
+            return 1;
+        }
+        int result = emitc_translate(input_filename, c_file);
+        fclose(c_file);
+        if (result != 0) {
+            remove(output_filename);
+            return 1;
+        }
+        printf("C source saved to '%s'\n", output_filename);
+        return 0;
+    }
+    
+    // Сессии: много скриптов в одном потоке, каждый со своим полем
+    if (sessions_enabled) {
+        return run_sessions(input_filename, save_enabled ? output_filename : NULL, save_rle, session_quota) == 0 ? 0 : 1;
+    }
+    
     // Инициализация контекста интерпретатора
     InterpreterContext context;
     interpreter_init(&context);
     interpreter_set_display_options(&context, display_enabled, display_interval);
     interpreter_set_save_option(&context, save_enabled);
-    
-    // Открытие входного файла с командами
-    FILE* input_file = fopen(input_filename, "r");
-    if (input_file == NULL) {
-        printf("Error: Cannot open input file '%s'\n", input_filename);
+    interpreter_set_timing_option(&context, timing_enabled);
+    interpreter_set_stats_option(&context, stats_enabled);
+    interpreter_set_profile_option(&context, profile_enabled);
+    if (memo_enabled && interpreter_set_memo_option(&context, 1) != 0) {
         return 1;
     }
-    
-    // Чтение и выполнение команд из файла
-    char line[MAX_LINE_LENGTH];
-    int line_number = 0;
-    
-    while (read_line(input_file, line, sizeof(line)) != NULL && !context.error_occurred) {
-        line_number++;
-        
-        // Разбор строки команды
-        ParsedCommand cmd;
-        int parse_result = parse_line(line, &cmd);
-        
-        if (parse_result != 0) {
-            printf("Error parsing line %d: %s\n", line_number, line);
-            continue;
+    context.automaton.threads = crowd_threads;
+    if (rules_filename != NULL && automaton_load_rules(&context.automaton, rules_filename) != 0) {
+        return 1;
+    }
+    if (heatmap_filename != NULL) {
+        context.field.heatmap = heatmap_create();
+        if (context.field.heatmap == NULL) {
+            return 1;
         }
-        
-        // Пропуск комментариев
-        if (cmd.type == CMD_COMMENT) {
-            continue;
+    }
+    if (trace_filename != NULL && interpreter_set_trace_option(&context, TRACE_DEFAULT_CAPACITY) != 0) {
+        return 1;
+    }
+    
+    // Толпа динозавров: отдельный режим со своим форматом входного файла
+    if (crowd_enabled) {
+        if (run_crowd(&context.field, input_filename, crowd_threads, crowd_ticks) != 0) {
+            return 1;
         }
-        
-        // Выполнение команды
-        int exec_result = interpreter_execute_command(&context, &cmd, line_number);
-        if (exec_result < 0 && context.error_occurred) {
-            printf("Fatal error at line %d: %s\n", line_number, interpreter_get_error_message(&context));
-            break;
+        if (save_enabled) {
+            save_final_state(&context.field, output_filename, save_rle);
         }
+        printf("Program executed successfully!\n");
+        return 0;
+    }
+    
+    // Публикация поля для внешних наблюдателей (сегмент удаляется в interpreter_free)
+    if (live_name != NULL && interpreter_set_live_option(&context, live_name) != 0) {
+        return 1;
     }
     
-    // Закрытие входного файла
-    fclose(input_file);
+    // Выполнение скрипта: построчно или собранного из --emit-c
+    double run_start = get_time_seconds();
+    int run_result = native_enabled ? emitc_run_native(&context, input_filename)
+                                    : run_script(&context, input_filename);
+    if (run_result != 0) {
+        interpreter_free(&context);
+        return 1;
+    }
+    double run_time = get_time_seconds() - run_start;
+    if (context.trace.enabled) {
+        trace_file(&context.trace, input_filename, (run_start - context.trace.start_time) * 1e6,
+                   run_time * 1e6, 0);
+    }
+    double output_start = get_time_seconds();
     
     // Сохранение конечного состояния в выходной файл
     if (save_enabled && !context.error_occurred) {
-        FILE* output_file = fopen(output_filename, "w");
-        if (output_file != NULL) {
-            field_print(&context.field, output_file);
-            fclose(output_file);
-            printf("Final state saved to '%s'\n", output_filename);
+        save_final_state(&context.field, output_filename, save_rle);
+    }
+    
+    // Разбивка времени: разбор строк, выполнение команд, сохранение результата
+    if (timing_enabled) {
+        printf("Timing: commands=%ld parse=%.6f execute=%.6f output=%.6f\n",
+               context.commands_executed, context.parse_time,
+               run_time - context.parse_time, get_time_seconds() - output_start);
+    }
+    
+    // Статистика выполнения по типам команд
+    if (stats_enabled) {
+        stats_print_table(&context.stats, stdout);
+        if (stats_json_filename != NULL) {
+            FILE* stats_file = fopen(stats_json_filename, "w");
+            if (stats_file != NULL) {
+                stats_write_json(&context.stats, stats_file);
+                fclose(stats_file);
+                printf("Statistics saved to '%s'\n", stats_json_filename);
+            } else {
+                printf("Error: Cannot create statistics file '%s'\n", stats_json_filename);
+            }
+        }
+    }
+    
+    // Запись трассы выполнения
+    if (trace_filename != NULL) {
+        FILE* trace_file_out = fopen(trace_filename, "w");
+        if (trace_file_out != NULL) {
+            trace_write_json(&context.trace, trace_file_out);
+            fclose(trace_file_out);
+            printf("Trace saved to '%s' (%ld events, %ld dropped)\n", trace_filename,
+                   context.trace.count, context.trace.dropped);
         } else {
-            printf("Error: Cannot create output file '%s'\n", output_filename);
+            printf("Error: Cannot create trace file '%s'\n", trace_filename);
         }
+        trace_free(&context.trace);
+    }
+    
+    // Профиль по строкам скриптов
+    if (profile_enabled) {
+        profiler_print_hot_lines(&context.profile, stdout, PROFILE_HOT_LINES);
+        profiler_write_annotated(&context.profile);
+        profiler_free(&context.profile);
+    }
+    
+    // Итоги кэша результатов EXEC
+    if (context.exec_memo != NULL) {
+        memo_print_summary(context.exec_memo, stdout);
+    }
+    
+    interpreter_free(&context);
+    
+    // Карта активности клеток
+    if (heatmap_filename != NULL) {
+        heatmap_save(context.field.heatmap, &context.field, heatmap_filename);
+        heatmap_destroy(context.field.heatmap);
+        context.field.heatmap = NULL;
     }
     
     // Возврат кода ошибки, если была фатальная ошибка
@@ -0,0 +1,284 @@
+#include "memo.h"
+
+// Создание пустого кэша
+ExecMemo* memo_create(void) {
+    ExecMemo* memo = calloc(1, sizeof(ExecMemo));
+    if (memo == NULL) {
+        printf("Error: Cannot allocate EXEC memo\n");
+        return NULL;
+    }
+    field_init(&memo->before);
+    return memo;
+}
+
+static void memo_free_entry(MemoEntry* entry) {
+    for (int i = 0; i < entry->level_count; i++) {
+        free(entry->levels[i].changes);
+    }
+    free(entry->levels);
+    free(entry->changes);
+    free(entry->warnings);
+    entry->levels = NULL;
+    entry->level_count = 0;
+    entry->changes = NULL;
+    entry->warnings = NULL;
+    entry->valid = 0;
+}
+
+// Освобождение кэша
+void memo_destroy(ExecMemo* memo) {
+    if (memo == NULL) return;
+    for (int i = 0; i < MEMO_CAPACITY; i++) {
+        memo_free_entry(&memo->entries[i]);
+    }
+    free(memo);
+}
+
+// Хеш содержимого файла скрипта: из таблицы, если файл не менялся. -1, если файла нет
+int memo_script_hash(ExecMemo* memo, const char* filename, uint64_t* hash) {
+    MemoScript* script = NULL;
+    for (int i = 0; i < memo->script_count; i++) {
+        if (strcmp(memo->scripts[i].filename, filename) == 0) {
+            script = &memo->scripts[i];
+            break;
+        }
+    }
+    if (script != NULL && file_stamp_same(filename, &script->stamp)) {
+        *hash = script->hash;
+        return 0;
+    }
+
+    FileStamp stamp;
+    if (file_stamp_get(filename, &stamp) != 0) {
+        return -1;
+    }
+
+    if (script == NULL) {
+        if (memo->script_count < MEMO_SCRIPT_FILES) {
+            script = &memo->scripts[memo->script_count++];
+        } else {
+            script = &memo->scripts[memo->next_script];
+            memo->next_script = (memo->next_script + 1) % MEMO_SCRIPT_FILES;
+        }
+    }
+    // Хеш недавно измененного файла уже посчитан file_stamp_get
+    script->hash = stamp.content != 0 ? stamp.content : file_content_hash(filename);
+    if (script->hash == 0) {
+        script->filename[0] = '\0';
+        return -1;
+    }
+    snprintf(script->filename, sizeof(script->filename), "%s", filename);
+    script->stamp = stamp;
+    *hash = script->hash;
+    return 0;
+}
+
+// Ключ для EXEC файла с заданным хешем из текущего состояния поля
+void memo_make_key(MemoKey* key, uint64_t script_hash, const Field* field, int dino_placed) {
+    memset(key, 0, sizeof(MemoKey));
+    key->script_hash = script_hash;
+    key->field_hash = field->hash;
+    key->width = field->width;
+    key->height = field->height;
+    key->dino_x = field->dino_x;
+    key->dino_y = field->dino_y;
+    key->dino_placed = dino_placed;
+}
+
+static int memo_key_equal(const MemoKey* a, const MemoKey* b) {
+    return a->script_hash == b->script_hash && a->field_hash == b->field_hash &&
+           a->width == b->width && a->height == b->height &&
+           a->dino_x == b->dino_x && a->dino_y == b->dino_y && a->dino_placed == b->dino_placed;
+}
+
+// Поиск результата по ключу (учитывается в статистике попаданий)
+const MemoEntry* memo_lookup(ExecMemo* memo, const MemoKey* key) {
+    memo->clock++;
+    for (int i = 0; i < MEMO_CAPACITY; i++) {
+        MemoEntry* entry = &memo->entries[i];
+        if (entry->valid && memo_key_equal(&entry->key, key)) {
+            entry->last_used = memo->clock;
+            memo->hits++;
+            return entry;
+        }
+    }
+    memo->misses++;
+    return NULL;
+}
+
+// Применение разницы к полю (хеш и индексы обновляются как при командах)
+static void memo_apply_changes(const MemoChange* changes, int count, Field* field) {
+    for (int i = 0; i < count; i++) {
+        field_set_cell(field, changes[i].x, changes[i].y, changes[i].cell);
+    }
+}
+
+// Переход поля к сохраненному уровню UNDO (поле - на предыдущем уровне)
+void memo_apply_level(const MemoLevel* level, Field* field) {
+    memo_apply_changes(level->changes, level->change_count, field);
+    field->dino_x = level->dino_x;
+    field->dino_y = level->dino_y;
+}
+
+// Применение результата к полю на последнем уровне записи (без уровней - к полю до EXEC)
+void memo_apply(const MemoEntry* entry, Field* field) {
+    memo_apply_changes(entry->changes, entry->change_count, field);
+    field->dino_x = entry->dino_x;
+    field->dino_y = entry->dino_y;
+}
+
+// Начало записи результата EXEC. Записываемый внешний EXEC отменяется
+void memo_begin(ExecMemo* memo, const MemoKey* key, const Field* field, int depth) {
+    memo_cancel(memo);
+    memo->recording = depth;
+    memo->recording_key = *key;
+    field_copy(&memo->before, field);
+    memo->warning_count = 0;
+    memo->warnings_dropped = 0;
+    memo->level_count = 0;
+}
+
+// Отмена записи: результат зависит не только от поля и файла
+void memo_cancel(ExecMemo* memo) {
+    if (memo->recording) {
+        memo->recording = 0;
+        memo->uncacheable++;
+    }
+}
+
+// Предупреждение во время записи
+void memo_warning(ExecMemo* memo, const char* warning) {
+    if (!memo->recording) {
+        return;
+    }
+    if (memo->warning_count < MEMO_MAX_WARNINGS) {
+        snprintf(memo->warnings[memo->warning_count++], sizeof(memo->warnings[0]), "%s", warning);
+    } else {
+        memo->warnings_dropped++;
+    }
+}
+
+// Уровень UNDO, сохраненный во время записи (поле на момент сохранения)
+void memo_level(ExecMemo* memo, const Field* field) {
+    if (!memo->recording) {
+        return;
+    }
+    field_copy(&memo->levels[memo->level_count % MEMO_MAX_LEVELS], field);
+    memo->level_count++;
+}
+
+// Число клеток to, отличающихся от from (размеры внутри EXEC не меняются)
+static int memo_count_changes(const Field* from, const Field* to) {
+    int count = 0;
+    for (int x = 0; x < to->width; x++) {
+        for (int y = 0; y < to->height; y++) {
+            if (memcmp(&to->grid[x][y], &from->grid[x][y], sizeof(Cell)) != 0) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Клетки to, отличающиеся от from. -1 - нет памяти
+static int memo_diff(const Field* from, const Field* to, MemoChange** changes) {
+    int count = memo_count_changes(from, to);
+    *changes = malloc((count > 0 ? count : 1) * sizeof(MemoChange));
+    if (*changes == NULL) {
+        return -1;
+    }
+    count = 0;
+    for (int x = 0; x < to->width; x++) {
+        for (int y = 0; y < to->height; y++) {
+            if (memcmp(&to->grid[x][y], &from->grid[x][y], sizeof(Cell)) != 0) {
+                (*changes)[count].x = (unsigned char)x;
+                (*changes)[count].y = (unsigned char)y;
+                (*changes)[count].cell = to->grid[x][y];
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Место для нового результата: свободное или давно не использованное
+static MemoEntry* memo_victim(ExecMemo* memo) {
+    MemoEntry* victim = &memo->entries[0];
+    for (int i = 0; i < MEMO_CAPACITY; i++) {
+        MemoEntry* entry = &memo->entries[i];
+        if (!entry->valid) {
+            return entry;
+        }
+        if (entry->last_used < victim->last_used) {
+            victim = entry;
+        }
+    }
+    memo_free_entry(victim);
+    memo->evictions++;
+    return victim;
+}
+
+// Конец EXEC на глубине depth: сохранение результата, если запись не отменена
+void memo_end(ExecMemo* memo, int depth, const Field* field, int dino_placed, int result, int failed) {
+    if (memo->recording != depth) {
+        return;
+    }
+    if (failed) {
+        memo_cancel(memo);
+        return;
+    }
+    memo->recording = 0;
+
+    // Уровни UNDO цепочкой разниц: каждый относительно предыдущего
+    int level_count = memo->level_count < MEMO_MAX_LEVELS ? (int)memo->level_count : MEMO_MAX_LEVELS;
+    MemoEntry* entry = memo_victim(memo);
+    entry->levels = calloc(level_count > 0 ? level_count : 1, sizeof(MemoLevel));
+    entry->warnings = malloc((memo->warning_count > 0 ? memo->warning_count : 1) * sizeof(entry->warnings[0]));
+    if (entry->levels == NULL || entry->warnings == NULL) {
+        memo_free_entry(entry);
+        return;
+    }
+
+    const Field* base = &memo->before;
+    for (int i = 0; i < level_count; i++) {
+        const Field* level = &memo->levels[(memo->level_count - level_count + i) % MEMO_MAX_LEVELS];
+        int count = memo_diff(base, level, &entry->levels[i].changes);
+        if (count < 0) {
+            memo_free_entry(entry);
+            return;
+        }
+        entry->levels[i].change_count = count;
+        entry->levels[i].dino_x = level->dino_x;
+        entry->levels[i].dino_y = level->dino_y;
+        entry->level_count = i + 1;
+        base = level;
+    }
+
+    int count = memo_diff(base, field, &entry->changes);
+    if (count < 0) {
+        memo_free_entry(entry);
+        return;
+    }
+    entry->cells_changed = base == &memo->before ? count : memo_count_changes(&memo->before, field);
+    memcpy(entry->warnings, memo->warnings, memo->warning_count * sizeof(entry->warnings[0]));
+
+    entry->key = memo->recording_key;
+    entry->change_count = count;
+    entry->warning_count = memo->warning_count;
+    entry->warnings_dropped = memo->warnings_dropped;
+    entry->dino_x = field->dino_x;
+    entry->dino_y = field->dino_y;
+    entry->dino_placed = dino_placed;
+    entry->result = result;
+    entry->last_used = memo->clock;
+    entry->valid = 1;
+    memo->stores++;
+}
+
+// Итоги кэша
+void memo_print_summary(const ExecMemo* memo, FILE* output) {
+    long lookups = memo->hits + memo->misses;
+    fprintf(output, "EXEC memo: %ld hits, %ld misses (%.1f%% hit rate), %ld stored, %ld evicted, %ld not cacheable\n",
+            memo->hits, memo->misses, lookups > 0 ? 100.0 * memo->hits / lookups : 0.0,
+            memo->stores, memo->evictions, memo->uncacheable);
+}
@@ -0,0 +1,103 @@
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <stdint.h>
+#include "field.h"
+#include "utils.h"
+
+#define MEMO_CAPACITY 256           // Результатов EXEC в кэше (вытеснение LRU)
+#define MEMO_SCRIPT_FILES 64        // Хешей содержимого файлов
+#define MEMO_MAX_WARNINGS 16        // Сохраняемых предупреждений на результат
+#define MEMO_MAX_LEVELS 20          // Сохраняемых уровней UNDO на результат (не меньше MAX_UNDO_LEVELS)
+
+// Ключ результата: содержимое файла и входное состояние поля
+typedef struct {
+    uint64_t script_hash;
+    uint64_t field_hash;
+    int width, height;
+    int dino_x, dino_y;
+    int dino_placed;
+} MemoKey;
+
+// Изменение клетки в результате EXEC
+typedef struct {
+    unsigned char x, y;
+    Cell cell;
+} MemoChange;
+
+// Уровень истории UNDO, сохраненный командой файла: разница с предыдущим уровнем
+// (первый - с полем до EXEC)
+typedef struct {
+    MemoChange* changes;
+    int change_count;
+    int dino_x, dino_y;
+} MemoLevel;
+
+// Сохраненный результат EXEC: уровни UNDO, разница полей и предупреждения.
+// Из уровней хранятся последние MEMO_MAX_LEVELS - более ранние все равно
+// вытесняются из истории
+typedef struct {
+    int valid;
+    MemoKey key;
+    unsigned long long last_used;
+    MemoLevel* levels;
+    int level_count;
+    MemoChange* changes;            // Разница с последним уровнем (без уровней - с полем до EXEC)
+    int change_count;
+    int cells_changed;              // Клеток, отличающихся от поля до EXEC
+    int dino_x, dino_y;             // Положение динозавра после EXEC
+    int dino_placed;
+    int result;                     // Код результата EXEC
+    char (*warnings)[256];
+    int warning_count;
+    int warnings_dropped;           // Не поместились в MEMO_MAX_WARNINGS
+} MemoEntry;
+
+// Хеш содержимого файла скрипта (пересчитывается, если файл изменился)
+typedef struct {
+    char filename[256];
+    FileStamp stamp;            // Состояние файла при подсчете хеша
+    uint64_t hash;
+} MemoScript;
+
+// Кэш результатов EXEC (--memo-exec)
+typedef struct ExecMemo {
+    MemoEntry entries[MEMO_CAPACITY];
+    unsigned long long clock;
+    MemoScript scripts[MEMO_SCRIPT_FILES];
+    int script_count;
+    int next_script;                // Вытесняемый хеш файла (по кругу)
+
+    // Запись выполняемого EXEC (одна: вложенный EXEC делает внешний некэшируемым)
+    int recording;                  // Глубина EXEC записываемого файла, 0 - записи нет
+    MemoKey recording_key;
+    Field before;                   // Поле до EXEC
+    Field levels[MEMO_MAX_LEVELS];  // Последние уровни UNDO файла (по кругу)
+    long level_count;               // Всего уровней, сохраненных во время записи
+    char warnings[MEMO_MAX_WARNINGS][256];
+    int warning_count;
+    int warnings_dropped;
+
+    long hits;
+    long misses;
+    long stores;
+    long evictions;
+    long uncacheable;               // Записи отменены (UNDO, LOAD, SIZE, STAMP, вложенный EXEC, ошибка)
+} ExecMemo;
+
+// Функции кэша результатов EXEC
+ExecMemo* memo_create(void);
+void memo_destroy(ExecMemo* memo);
+int memo_script_hash(ExecMemo* memo, const char* filename, uint64_t* hash);
+void memo_make_key(MemoKey* key, uint64_t script_hash, const Field* field, int dino_placed);
+const MemoEntry* memo_lookup(ExecMemo* memo, const MemoKey* key);
+void memo_apply_level(const MemoLevel* level, Field* field);
+void memo_apply(const MemoEntry* entry, Field* field);
+void memo_begin(ExecMemo* memo, const MemoKey* key, const Field* field, int depth);
+void memo_cancel(ExecMemo* memo);
+void memo_warning(ExecMemo* memo, const char* warning);
+void memo_level(ExecMemo* memo, const Field* field);
+void memo_end(ExecMemo* memo, int depth, const Field* field, int dino_placed, int result, int failed);
+void memo_print_summary(const ExecMemo* memo, FILE* output);
+
+#endif
@@ -187,6 +187,119 @@ int parse_line(const char* line, ParsedCommand* cmd) {
         }
         cmd->type = CMD_UNDO;
     }
+    else if (strcasecmp(tokens[0], "GOTO") == 0) {
+        if (token_count != 3) {
+            printf("Syntax Error: GOTO requires 2 arguments (x y)\n");
+            return -2;
+        }
+        cmd->type = CMD_GOTO;
+        cmd->x = atoi(tokens[1]);
+        cmd->y = atoi(tokens[2]);
+    }
+    else if (strcasecmp(tokens[0], "TICK") == 0) {
+        if (token_count != 2) {
+            printf("Syntax Error: TICK requires 1 argument (generations)\n");
+            return -2;
+        }
+        cmd->type = CMD_TICK;
+        cmd->n = atoi(tokens[1]);
+    }
+    else if (strcasecmp(tokens[0], "FILL") == 0) {
+        if (token_count != 6 || strlen(tokens[5]) != 1) {
+            printf("Syntax Error: FILL requires 5 arguments (x1 y1 x2 y2 symbol)\n");
+            return -2;
+        }
+        cmd->type = CMD_FILL;
+        cmd->x = atoi(tokens[1]);
+        cmd->y = atoi(tokens[2]);
+        cmd->x2 = atoi(tokens[3]);
+        cmd->y2 = atoi(tokens[4]);
+        cmd->color = tokens[5][0];
+    }
+    else if (strcasecmp(tokens[0], "CLEAR") == 0) {
+        if (token_count != 5) {
+            printf("Syntax Error: CLEAR requires 4 arguments (x1 y1 x2 y2)\n");
+            return -2;
+        }
+        cmd->type = CMD_CLEAR;
+        cmd->x = atoi(tokens[1]);
+        cmd->y = atoi(tokens[2]);
+        cmd->x2 = atoi(tokens[3]);
+        cmd->y2 = atoi(tokens[4]);
+    }
+    else if (strcasecmp(tokens[0], "REPLACE") == 0) {
+        // REPLACE s1 WITH s2 IN x1 y1 x2 y2
+        if (token_count != 9 || strcasecmp(tokens[2], "WITH") != 0 || strcasecmp(tokens[4], "IN") != 0 ||
+            strlen(tokens[1]) != 1 || strlen(tokens[3]) != 1) {
+            printf("Syntax Error: REPLACE must follow format: REPLACE symbol WITH symbol IN x1 y1 x2 y2\n");
+            return -2;
+        }
+        cmd->type = CMD_REPLACE;
+        cmd->color = tokens[1][0];
+        cmd->replacement = tokens[3][0];
+        cmd->x = atoi(tokens[5]);
+        cmd->y = atoi(tokens[6]);
+        cmd->x2 = atoi(tokens[7]);
+        cmd->y2 = atoi(tokens[8]);
+    }
+    else if (strcasecmp(tokens[0], "STAMP") == 0) {
+        if (token_count != 4) {
+            printf("Syntax Error: STAMP requires 3 arguments (filename x y)\n");
+            return -2;
+        }
+        cmd->type = CMD_STAMP;
+        strncpy(cmd->filename, tokens[1], sizeof(cmd->filename) - 1);
+        cmd->x = atoi(tokens[2]);
+        cmd->y = atoi(tokens[3]);
+    }
+    else if (strcasecmp(tokens[0], "IF") == 0 && token_count > 1 && strcasecmp(tokens[1], "COUNT") == 0) {
+        if (token_count < 12) {
+            printf("Syntax Error: IF COUNT requires at least 11 arguments\n");
+            return -2;
+        }
+        // IF COUNT x1 y1 x2 y2 OF symbol op k THEN command
+        if (strcasecmp(tokens[6], "OF") != 0 || strcasecmp(tokens[10], "THEN") != 0 ||
+            strlen(tokens[8]) != 1 || strchr("<>=", tokens[8][0]) == NULL) {
+            printf("Syntax Error: IF COUNT must follow format: IF COUNT x1 y1 x2 y2 OF symbol >|<|= k THEN command\n");
+            return -2;
+        }
+        cmd->type = CMD_IF;
+        cmd->condition = IF_COUNT;
+        cmd->x = atoi(tokens[2]);
+        cmd->y = atoi(tokens[3]);
+        cmd->x2 = atoi(tokens[4]);
+        cmd->y2 = atoi(tokens[5]);
+        cmd->color = tokens[7][0];
+        cmd->compare = tokens[8][0];
+        cmd->n = atoi(tokens[9]);
+        
+        strcpy(cmd->then_command, "");
+        for (int i = 11; i < token_count; i++) {
+            if (i > 11) strcat(cmd->then_command, " ");
+            strcat(cmd->then_command, tokens[i]);
+        }
+    }
+    else if (strcasecmp(tokens[0], "IF") == 0 && token_count > 1 && strcasecmp(tokens[1], "NEAREST") == 0) {
+        if (token_count < 7) {
+            printf("Syntax Error: IF NEAREST requires at least 6 arguments\n");
+            return -2;
+        }
+        // IF NEAREST symbol WITHIN d THEN command
+        if (strcasecmp(tokens[3], "WITHIN") != 0 || strcasecmp(tokens[5], "THEN") != 0) {
+            printf("Syntax Error: IF NEAREST must follow format: IF NEAREST symbol WITHIN d THEN command\n");
+            return -2;
+        }
+        cmd->type = CMD_IF;
+        cmd->condition = IF_NEAREST;
+        cmd->color = tokens[2][0];
+        cmd->n = atoi(tokens[4]);
+        
+        strcpy(cmd->then_command, "");
+        for (int i = 6; i < token_count; i++) {
+            if (i > 6) strcat(cmd->then_command, " ");
+            strcat(cmd->then_command, tokens[i]);
+        }
+    }
     else if (strcasecmp(tokens[0], "IF") == 0) {
         
         if (token_count < 8) {
@@ -200,6 +313,7 @@ int parse_line(const char* line, ParsedCommand* cmd) {
             return -2;
         }
         cmd->type = CMD_IF;
+        cmd->condition = IF_CELL;
         cmd->x = atoi(tokens[2]);
         cmd->y = atoi(tokens[3]);
         cmd->color = tokens[5][0];
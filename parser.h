@@ -7,13 +7,24 @@
 #define MAX_LINE_LENGTH 256
 #define MAX_FILENAME_LENGTH 100
 
+// Вид условия IF
+typedef enum {
+    IF_CELL,        // IF CELL x y IS s
+    IF_COUNT,       // IF COUNT x1 y1 x2 y2 OF s > k
+    IF_NEAREST      // IF NEAREST s WITHIN d
+} IfCondition;
+
 // Структура для представления разобранной команды
 typedef struct {
     CommandType type;               // Тип команды
     char direction[10];             // Направление (для MOVE, DIG, JUMP и других)
     int x, y, n;                    // Координаты и числовые параметры
-    char color;                     // Цвет для покраски
-    char filename[MAX_FILENAME_LENGTH]; // Имя файла для EXEC/LOAD
+    int x2, y2;                     // Второй угол области (IF COUNT)
+    char color;                     // Цвет для покраски (символ в условии IF, FILL, REPLACE)
+    char replacement;               // Новый символ для REPLACE
+    IfCondition condition;          // Вид условия IF
+    char compare;                   // Сравнение в IF COUNT: '>', '<' или '='
+    char filename[MAX_FILENAME_LENGTH]; // Имя файла для EXEC/LOAD/STAMP
     char then_command[MAX_LINE_LENGTH]; // Команда после THEN для IF
 } ParsedCommand;
 
@@ -0,0 +1,270 @@
+#include "pathfind.h"
+
+// Смещения соседей в порядке UP, DOWN, LEFT, RIGHT (порядок выбора шага детерминирован)
+static const int neighbor_dx[4] = { 0, 0, -1, 1 };
+static const int neighbor_dy[4] = { -1, 1, 0, 0 };
+
+// Очередь BFS: индексы клеток x * MAX_HEIGHT + y
+static int bfs_queue[MAX_WIDTH * MAX_HEIGHT];
+
+// Создание пустого кэша
+PathCache* path_cache_create(void) {
+    PathCache* cache = calloc(1, sizeof(PathCache));
+    if (cache == NULL) {
+        printf("Error: Cannot allocate path cache\n");
+    }
+    return cache;
+}
+
+// Освобождение кэша
+void path_cache_destroy(PathCache* cache) {
+    free(cache);
+}
+
+// Клетка проходима для GOTO: пустая (возможно, окрашенная) или клетка динозавра
+static int path_cell_passable(const Cell* cell) {
+    return !(cell_flags(cell->type) & (CELL_FLAG_BLOCKS | CELL_FLAG_FATAL));
+}
+
+static int path_bit_index(const Field* field, int x, int y) {
+    return x * field->height + y;
+}
+
+static int path_bit(const uint64_t* bitmap, int index) {
+    return (int)((bitmap[index >> 6] >> (index & 63)) & 1);
+}
+
+static void path_set_bit(uint64_t* bitmap, int index, int value) {
+    if (value) {
+        bitmap[index >> 6] |= 1ULL << (index & 63);
+    } else {
+        bitmap[index >> 6] &= ~(1ULL << (index & 63));
+    }
+}
+
+// Текущая проходимость всех клеток поля
+static void path_build_bitmap(const Field* field, uint64_t* bitmap) {
+    memset(bitmap, 0, PATH_BITMAP_WORDS * sizeof(uint64_t));
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            if (path_cell_passable(&field->grid[x][y])) {
+                path_set_bit(bitmap, path_bit_index(field, x, y), 1);
+            }
+        }
+    }
+}
+
+// Распространение уменьшения расстояний от клеток в очереди
+static void path_propagate(DistanceField* entry, const Field* field, int head, int tail) {
+    while (head < tail) {
+        int x = bfs_queue[head] / MAX_HEIGHT;
+        int y = bfs_queue[head] % MAX_HEIGHT;
+        head++;
+
+        unsigned short next = entry->dist[x][y] + 1;
+        for (int i = 0; i < 4; i++) {
+            int nx = (x + neighbor_dx[i] + entry->width) % entry->width;
+            int ny = (y + neighbor_dy[i] + entry->height) % entry->height;
+            if (path_bit(entry->passable, path_bit_index(field, nx, ny)) && entry->dist[nx][ny] > next) {
+                entry->dist[nx][ny] = next;
+                bfs_queue[tail++] = nx * MAX_HEIGHT + ny;
+            }
+        }
+    }
+}
+
+// Полный пересчет поля расстояний (BFS от цели)
+static void path_rebuild(DistanceField* entry, const Field* field, const uint64_t* bitmap) {
+    memcpy(entry->passable, bitmap, sizeof(entry->passable));
+    entry->width = field->width;
+    entry->height = field->height;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            entry->dist[x][y] = PATH_UNREACHABLE;
+        }
+    }
+
+    entry->valid = 1;
+    if (!path_bit(bitmap, path_bit_index(field, entry->target_x, entry->target_y))) {
+        return;  // Цель занята - недостижима отовсюду
+    }
+
+    entry->dist[entry->target_x][entry->target_y] = 0;
+    bfs_queue[0] = entry->target_x * MAX_HEIGHT + entry->target_y;
+    path_propagate(entry, field, 0, 1);
+}
+
+// Клетка стала проходимой: расстояния могут только уменьшиться
+static void path_cell_opened(DistanceField* entry, const Field* field, int x, int y) {
+    path_set_bit(entry->passable, path_bit_index(field, x, y), 1);
+
+    unsigned short best = PATH_UNREACHABLE;
+    if (x == entry->target_x && y == entry->target_y) {
+        best = 0;
+    } else {
+        for (int i = 0; i < 4; i++) {
+            int nx = (x + neighbor_dx[i] + entry->width) % entry->width;
+            int ny = (y + neighbor_dy[i] + entry->height) % entry->height;
+            if (path_bit(entry->passable, path_bit_index(field, nx, ny)) &&
+                entry->dist[nx][ny] != PATH_UNREACHABLE && entry->dist[nx][ny] + 1 < best) {
+                best = entry->dist[nx][ny] + 1;
+            }
+        }
+    }
+
+    entry->dist[x][y] = best;
+    if (best != PATH_UNREACHABLE) {
+        bfs_queue[0] = x * MAX_HEIGHT + y;
+        path_propagate(entry, field, 0, 1);
+    }
+}
+
+// Клетка стала непроходимой. Возвращает 0, если хватило локального обновления,
+// и -1, если от нее зависят расстояния соседей (нужен полный пересчет)
+static int path_cell_blocked(DistanceField* entry, const Field* field, int x, int y) {
+    path_set_bit(entry->passable, path_bit_index(field, x, y), 0);
+
+    unsigned short dist = entry->dist[x][y];
+    entry->dist[x][y] = PATH_UNREACHABLE;
+    if (dist == PATH_UNREACHABLE) {
+        return 0;
+    }
+    if (dist == 0) {
+        return -1;  // Заблокирована сама цель
+    }
+
+    // Сосед на расстоянии dist + 1 зависит от клетки, если у него нет другой опоры на dist
+    for (int i = 0; i < 4; i++) {
+        int nx = (x + neighbor_dx[i] + entry->width) % entry->width;
+        int ny = (y + neighbor_dy[i] + entry->height) % entry->height;
+        if (!path_bit(entry->passable, path_bit_index(field, nx, ny)) || entry->dist[nx][ny] != dist + 1) {
+            continue;
+        }
+
+        int supported = 0;
+        for (int j = 0; j < 4 && !supported; j++) {
+            int sx = (nx + neighbor_dx[j] + entry->width) % entry->width;
+            int sy = (ny + neighbor_dy[j] + entry->height) % entry->height;
+            supported = path_bit(entry->passable, path_bit_index(field, sx, sy)) && entry->dist[sx][sy] == dist;
+        }
+        if (!supported) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Приведение поля расстояний к текущему состоянию поля по измененным клеткам
+static void path_refresh(PathCache* cache, DistanceField* entry, const Field* field, const uint64_t* bitmap) {
+    if (entry->width != field->width || entry->height != field->height) {
+        path_rebuild(entry, field, bitmap);
+        cache->rebuilds++;
+        return;
+    }
+
+    int words = (field->width * field->height + 63) / 64;
+    int changed = 0;
+    for (int w = 0; w < words; w++) {
+        changed += __builtin_popcountll(entry->passable[w] ^ bitmap[w]);
+    }
+    if (changed == 0) {
+        cache->hits++;
+        return;
+    }
+    if (changed > PATH_MAX_INCREMENTAL) {
+        path_rebuild(entry, field, bitmap);
+        cache->rebuilds++;
+        return;
+    }
+
+    for (int w = 0; w < words; w++) {
+        uint64_t diff = entry->passable[w] ^ bitmap[w];
+        while (diff != 0) {
+            int index = w * 64 + __builtin_ctzll(diff);
+            diff &= diff - 1;
+
+            int x = index / field->height;
+            int y = index % field->height;
+            if (path_bit(bitmap, index)) {
+                path_cell_opened(entry, field, x, y);
+            } else if (path_cell_blocked(entry, field, x, y) != 0) {
+                path_rebuild(entry, field, bitmap);
+                cache->rebuilds++;
+                return;
+            }
+        }
+    }
+    cache->updates++;
+}
+
+// Поле расстояний до цели: из кэша (с обновлением) или посчитанное заново
+const DistanceField* path_cache_get(PathCache* cache, const Field* field, int target_x, int target_y) {
+    static uint64_t bitmap[PATH_BITMAP_WORDS];
+    DistanceField* entry = NULL;
+    DistanceField* oldest = &cache->entries[0];
+
+    path_build_bitmap(field, bitmap);
+    cache->clock++;
+
+    for (int i = 0; i < PATH_CACHE_SIZE; i++) {
+        DistanceField* candidate = &cache->entries[i];
+        if (candidate->valid && candidate->target_x == target_x && candidate->target_y == target_y) {
+            entry = candidate;
+            break;
+        }
+        if (!candidate->valid || candidate->last_used < oldest->last_used) {
+            oldest = candidate;
+        }
+    }
+
+    if (entry != NULL) {
+        path_refresh(cache, entry, field, bitmap);
+    } else {
+        entry = oldest;
+        entry->target_x = target_x;
+        entry->target_y = target_y;
+        path_rebuild(entry, field, bitmap);
+        cache->rebuilds++;
+    }
+
+    entry->last_used = cache->clock;
+    return entry;
+}
+
+// Перемещение динозавра кратчайшим путем к клетке (x, y).
+// Возвращает число шагов или код ошибки: -1 динозавр не размещен,
+// -2 координаты вне поля, -11 путь не найден
+int path_goto(PathCache* cache, Field* field, int target_x, int target_y) {
+    if (field->dino_x == -1 || field->dino_y == -1) {
+        printf("Error: Dino not placed. Use START command\n");
+        return -1;
+    }
+    if (target_x < 0 || target_x >= field->width || target_y < 0 || target_y >= field->height) {
+        printf("Error: Coordinates (%d, %d) out of field bounds %dx%d\n",
+               target_x, target_y, field->width, field->height);
+        return -2;
+    }
+
+    const DistanceField* entry = path_cache_get(cache, field, target_x, target_y);
+    if (entry->dist[field->dino_x][field->dino_y] == PATH_UNREACHABLE) {
+        return -11;
+    }
+
+    // Спуск по полю расстояний: каждый шаг - обычное перемещение динозавра
+    int steps = 0;
+    while (entry->dist[field->dino_x][field->dino_y] > 0) {
+        unsigned short current = entry->dist[field->dino_x][field->dino_y];
+        for (int i = 0; i < 4; i++) {
+            int nx = (field->dino_x + neighbor_dx[i] + field->width) % field->width;
+            int ny = (field->dino_y + neighbor_dy[i] + field->height) % field->height;
+            if (entry->dist[nx][ny] == current - 1) {
+                field_move_dino(field, neighbor_dx[i], neighbor_dy[i]);
+                break;
+            }
+        }
+        steps++;
+    }
+
+    printf("Dino reached (%d, %d) in %d steps\n", target_x, target_y, steps);
+    return steps;
+}
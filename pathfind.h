@@ -0,0 +1,37 @@
+#ifndef PATHFIND_H
+#define PATHFIND_H
+
+#include <stdint.h>
+#include "field.h"
+
+#define PATH_CACHE_SIZE 8           // Сколько целей хранится одновременно
+#define PATH_UNREACHABLE 0xFFFF     // Расстояние до недостижимой клетки
+#define PATH_MAX_INCREMENTAL 64     // Больше изменений - пересчет поля расстояний целиком
+#define PATH_BITMAP_WORDS ((MAX_WIDTH * MAX_HEIGHT + 63) / 64)
+
+// Поле расстояний до одной цели (BFS по тору в обход препятствий и ям)
+typedef struct {
+    int valid;
+    int target_x, target_y;
+    int width, height;
+    unsigned long long last_used;               // Для вытеснения (LRU)
+    uint64_t passable[PATH_BITMAP_WORDS];       // Проходимость, для которой посчитаны расстояния
+    unsigned short dist[MAX_WIDTH][MAX_HEIGHT];
+} DistanceField;
+
+// Кэш полей расстояний для команды GOTO
+typedef struct {
+    DistanceField entries[PATH_CACHE_SIZE];
+    unsigned long long clock;
+    long hits;              // Поле расстояний использовано без изменений
+    long updates;           // Поле расстояний обновлено по измененным клеткам
+    long rebuilds;          // Поле расстояний посчитано заново
+} PathCache;
+
+// Функции поиска пути
+PathCache* path_cache_create(void);
+void path_cache_destroy(PathCache* cache);
+const DistanceField* path_cache_get(PathCache* cache, const Field* field, int target_x, int target_y);
+int path_goto(PathCache* cache, Field* field, int target_x, int target_y);
+
+#endif
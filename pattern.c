@@ -0,0 +1,234 @@
+#include "pattern.h"
+#include "counts.h"
+
+// Клетка шаблона по символу файла; 0 - символ прозрачен
+static int pattern_cell_from_symbol(char symbol, Cell* cell) {
+    if (symbol >= 'a' && symbol <= 'z') {
+        cell->type = CELL_EMPTY;
+        cell->color = symbol;
+        return 1;
+    }
+
+    // '_', '#' и прочие символы не копируются
+    if (symbol == CELL_EMPTY || !(cell_flags((CellType)symbol) & CELL_FLAG_OBJECT)) {
+        return 0;
+    }
+    cell->color = '\0';
+    cell->type = (CellType)symbol;
+    return 1;
+}
+
+static void pattern_free(Pattern* pattern) {
+    free(pattern->cells);
+    free(pattern->runs);
+    pattern->cells = NULL;
+    pattern->runs = NULL;
+    pattern->run_count = 0;
+}
+
+// Разбор файла шаблона: символы строк читаются в буфер, затем раскладываются
+// по столбцам, а маска прозрачности сжимается в серии непрозрачных клеток
+static int pattern_parse(FILE* file, const char* filename, Pattern* pattern) {
+    static char rows[MAX_HEIGHT][MAX_WIDTH];
+    static unsigned char mask[MAX_WIDTH][MAX_HEIGHT];
+    char line[4 * MAX_WIDTH + 2];  // Строка RLE может быть длиннее строки поля
+    int lengths[MAX_HEIGHT];
+    int width = 0;
+    int height = 0;
+    int is_rle = 0;
+
+    // Цифры не встречаются в обычном формате - по ним определяется RLE
+    while (fgets(line, sizeof(line), file)) {
+        if (strpbrk(line, "0123456789") != NULL) {
+            is_rle = 1;
+            break;
+        }
+    }
+    fseek(file, 0, SEEK_SET);
+
+    while (fgets(line, sizeof(line), file)) {
+        if (height == MAX_HEIGHT) {
+            printf("Error: Pattern '%s' has more than %d lines\n", filename, MAX_HEIGHT);
+            return -1;
+        }
+        int length = field_decode_line(line, is_rle, rows[height]);
+        if (length < 0) {
+            printf("Error: Invalid pattern data in file '%s' at line %d\n", filename, height + 1);
+            return -1;
+        }
+        lengths[height++] = length;
+        if (length > width) {
+            width = length;
+        }
+    }
+
+    if (width == 0 || height == 0) {
+        printf("Error: Pattern file '%s' is empty\n", filename);
+        return -1;
+    }
+
+    pattern->cells = calloc((size_t)width * height, sizeof(Cell));
+    pattern->runs = malloc((size_t)width * ((height + 1) / 2) * sizeof(PatternRun));
+    if (pattern->cells == NULL || pattern->runs == NULL) {
+        printf("Error: Cannot allocate memory for pattern\n");
+        pattern_free(pattern);
+        return -1;
+    }
+    pattern->width = width;
+    pattern->height = height;
+    pattern->opaque = 0;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            Cell* cell = &pattern->cells[x * height + y];
+            mask[x][y] = x < lengths[y] && pattern_cell_from_symbol(rows[y][x], cell);
+        }
+    }
+
+    for (int x = 0; x < width; x++) {
+        int y = 0;
+        while (y < height) {
+            if (!mask[x][y]) {
+                y++;
+                continue;
+            }
+            int start = y;
+            while (y < height && mask[x][y]) {
+                y++;
+            }
+            PatternRun* run = &pattern->runs[pattern->run_count++];
+            run->x = x;
+            run->y = start;
+            run->length = y - start;
+            pattern->opaque += y - start;
+        }
+    }
+    return 0;
+}
+
+PatternCache* pattern_cache_create(void) {
+    PatternCache* cache = calloc(1, sizeof(PatternCache));
+    if (cache == NULL) {
+        printf("Error: Cannot allocate pattern cache\n");
+    }
+    return cache;
+}
+
+void pattern_cache_destroy(PatternCache* cache) {
+    if (cache == NULL) return;
+    for (int i = 0; i < cache->count; i++) {
+        pattern_free(&cache->entries[i]);
+    }
+    free(cache);
+}
+
+// Разобранный шаблон из кэша; NULL, если файл не открывается или содержит ошибку
+const Pattern* pattern_cache_get(PatternCache* cache, const char* filename) {
+    cache->clock++;
+
+    Pattern* entry = NULL;
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].filename, filename) == 0) {
+            entry = &cache->entries[i];
+            break;
+        }
+    }
+    if (entry != NULL && file_stamp_same(filename, &entry->stamp)) {
+        cache->hits++;
+        entry->last_used = cache->clock;
+        return entry;
+    }
+
+    FileStamp stamp;
+    if (file_stamp_get(filename, &stamp) != 0) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return NULL;
+    }
+
+    // Новый файл вытесняет давно не использованный
+    if (entry == NULL) {
+        if (cache->count < PATTERN_CACHE_SIZE) {
+            entry = &cache->entries[cache->count++];
+        } else {
+            entry = &cache->entries[0];
+            for (int i = 1; i < cache->count; i++) {
+                if (cache->entries[i].last_used < entry->last_used) {
+                    entry = &cache->entries[i];
+                }
+            }
+        }
+    }
+    pattern_free(entry);
+    entry->filename[0] = '\0';
+    cache->misses++;
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return NULL;
+    }
+    int result = pattern_parse(file, filename, entry);
+    fclose(file);
+    if (result != 0) {
+        return NULL;
+    }
+
+    snprintf(entry->filename, sizeof(entry->filename), "%s", filename);
+    entry->stamp = stamp;
+    entry->last_used = cache->clock;
+    return entry;
+}
+
+// Копирование шаблона в поле с левым верхним углом (x, y) и переходом через края.
+// Серии непрозрачных клеток копируются memcpy (столбец поля непрерывен в памяти),
+// серия через нижний край делится на две. Клетка динозавра не меняется.
+// Возвращает число записанных клеток или -1, если поле не задано или шаблон больше поля
+int pattern_stamp(const Pattern* pattern, Field* field, int x, int y) {
+    if (field->width == 0 || field->height == 0) {
+        return -1;
+    }
+    if (pattern->width > field->width || pattern->height > field->height) {
+        printf("Error: Pattern %dx%d does not fit field %dx%d\n",
+               pattern->width, pattern->height, field->width, field->height);
+        return -1;
+    }
+
+    x = ((x % field->width) + field->width) % field->width;
+    y = ((y % field->height) + field->height) % field->height;
+
+    Cell dino_cell;
+    int has_dino = field->dino_x != -1 && field->dino_y != -1;
+    if (has_dino) {
+        dino_cell = field->grid[field->dino_x][field->dino_y];
+    }
+
+    int total = pattern->opaque;
+    for (int i = 0; i < pattern->run_count; i++) {
+        const PatternRun* run = &pattern->runs[i];
+        const Cell* source = &pattern->cells[run->x * pattern->height + run->y];
+        int tx = (x + run->x) % field->width;
+        int ty = (y + run->y) % field->height;
+        int head = field->height - ty;
+
+        if (run->length <= head) {
+            memcpy(&field->grid[tx][ty], source, run->length * sizeof(Cell));
+        } else {
+            memcpy(&field->grid[tx][ty], source, head * sizeof(Cell));
+            memcpy(&field->grid[tx][0], source + head, (run->length - head) * sizeof(Cell));
+        }
+
+        if (has_dino && tx == field->dino_x) {
+            int offset = (field->dino_y - ty + field->height) % field->height;
+            if (offset < run->length) {
+                total--;  // Клетка динозавра восстанавливается ниже
+            }
+        }
+    }
+
+    if (has_dino) {
+        field->grid[field->dino_x][field->dino_y] = dino_cell;
+    }
+    field_rehash(field);
+    counts_invalidate(field->counts);
+    return total;
+}
@@ -0,0 +1,43 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include "field.h"
+#include "utils.h"
+
+#define PATTERN_CACHE_SIZE 32   // Шаблонов в кэше
+
+// Шаблон для STAMP - файл в формате поля (обычный или RLE) любого размера до MAX_WIDTH x MAX_HEIGHT.
+// '_', '#' и символы вне формата поля прозрачны: клетки поля под ними не меняются
+typedef struct {
+    short x, y;                 // Начало серии непрозрачных клеток в столбце шаблона
+    short length;
+} PatternRun;
+
+typedef struct {
+    char filename[256];
+    FileStamp stamp;            // Состояние файла при разборе
+    unsigned long long last_used;
+    int width;
+    int height;
+    Cell* cells;                // Клетки по столбцам (cells[x * height + y]), как в Field.grid
+    PatternRun* runs;           // Маска прозрачности, сжатая в серии непрозрачных клеток
+    int run_count;
+    int opaque;                 // Число непрозрачных клеток
+} Pattern;
+
+// Кэш разобранных шаблонов: файл разбирается заново, только если изменился
+typedef struct {
+    Pattern entries[PATTERN_CACHE_SIZE];
+    int count;
+    unsigned long long clock;
+    long hits;
+    long misses;
+} PatternCache;
+
+// Функции шаблонов
+PatternCache* pattern_cache_create(void);
+void pattern_cache_destroy(PatternCache* cache);
+const Pattern* pattern_cache_get(PatternCache* cache, const char* filename);
+int pattern_stamp(const Pattern* pattern, Field* field, int x, int y);
+
+#endif
@@ -0,0 +1,208 @@
+#include "profile.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_LINE_TEXT 256
+
+// Строка для списка самых "горячих"
+typedef struct {
+    int file_index;
+    int line_number;
+    const LineProfile* line;
+} HotLine;
+
+// Инициализация профилировщика (профилирование выключено)
+void profiler_init(Profiler* profiler) {
+    if (profiler == NULL) return;
+    
+    memset(profiler, 0, sizeof(*profiler));
+}
+
+// Освобождение памяти профиля
+void profiler_free(Profiler* profiler) {
+    if (profiler == NULL) return;
+    
+    for (int i = 0; i < profiler->file_count; i++) {
+        free(profiler->files[i].lines);
+    }
+    free(profiler->files);
+    profiler_init(profiler);
+}
+
+// Индекс файла в профиле (файл добавляется при первом обращении, -1 при ошибке)
+int profiler_file_index(Profiler* profiler, const char* filename) {
+    if (profiler == NULL || !profiler->enabled || filename == NULL) return -1;
+    
+    for (int i = 0; i < profiler->file_count; i++) {
+        if (strcmp(profiler->files[i].filename, filename) == 0) {
+            return i;
+        }
+    }
+    
+    if (profiler->file_count >= profiler->file_capacity) {
+        int capacity = profiler->file_capacity ? profiler->file_capacity * 2 : 8;
+        FileProfile* files = realloc(profiler->files, capacity * sizeof(FileProfile));
+        if (files == NULL) {
+            return -1;
+        }
+        profiler->files = files;
+        profiler->file_capacity = capacity;
+    }
+    
+    FileProfile* file = &profiler->files[profiler->file_count];
+    strncpy(file->filename, filename, PROFILE_MAX_FILENAME - 1);
+    file->filename[PROFILE_MAX_FILENAME - 1] = '\0';
+    file->lines = NULL;
+    file->capacity = 0;
+    return profiler->file_count++;
+}
+
+// Начало выполнения строки
+void profiler_line_begin(Profiler* profiler, ProfileMark* mark) {
+    if (profiler == NULL || !profiler->enabled) return;
+    
+    mark->saved_child_time = profiler->child_time;
+    profiler->child_time = 0.0;
+    mark->start = get_time_seconds();
+}
+
+// Конец выполнения строки: учет полного и собственного времени
+void profiler_line_end(Profiler* profiler, const ProfileMark* mark, int file_index, int line_number) {
+    if (profiler == NULL || !profiler->enabled) return;
+    
+    double elapsed = get_time_seconds() - mark->start;
+    double self_time = elapsed - profiler->child_time;
+    profiler->child_time = mark->saved_child_time + elapsed;
+    
+    if (file_index < 0 || file_index >= profiler->file_count || line_number <= 0) return;
+    
+    FileProfile* file = &profiler->files[file_index];
+    if (line_number >= file->capacity) {
+        int capacity = file->capacity ? file->capacity : 64;
+        while (capacity <= line_number) capacity *= 2;
+        
+        LineProfile* lines = realloc(file->lines, capacity * sizeof(LineProfile));
+        if (lines == NULL) {
+            return;
+        }
+        memset(lines + file->capacity, 0, (capacity - file->capacity) * sizeof(LineProfile));
+        file->lines = lines;
+        file->capacity = capacity;
+    }
+    
+    LineProfile* line = &file->lines[line_number];
+    line->count++;
+    line->total_time += elapsed;
+    line->self_time += self_time;
+}
+
+// Сравнение строк по убыванию собственного времени
+static int profiler_compare_hot(const void* a, const void* b) {
+    double ta = ((const HotLine*)a)->line->self_time;
+    double tb = ((const HotLine*)b)->line->self_time;
+    return (ta < tb) - (ta > tb);
+}
+
+// Чтение текста строки из файла скрипта (для отчета)
+static void profiler_read_source_line(const char* filename, int line_number, char* buffer, int size) {
+    buffer[0] = '\0';
+    
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) return;
+    
+    for (int i = 1; read_line(file, buffer, size) != NULL; i++) {
+        if (i == line_number) {
+            fclose(file);
+            return;
+        }
+    }
+    buffer[0] = '\0';
+    fclose(file);
+}
+
+// Вывод самых "горячих" строк по собственному времени
+void profiler_print_hot_lines(const Profiler* profiler, FILE* output, int limit) {
+    if (profiler == NULL || output == NULL) return;
+    
+    long total = 0;
+    for (int f = 0; f < profiler->file_count; f++) {
+        const FileProfile* file = &profiler->files[f];
+        for (int i = 0; i < file->capacity; i++) {
+            if (file->lines[i].count > 0) total++;
+        }
+    }
+    
+    HotLine* hot = malloc((total > 0 ? total : 1) * sizeof(HotLine));
+    if (hot == NULL) return;
+    
+    long n = 0;
+    for (int f = 0; f < profiler->file_count; f++) {
+        const FileProfile* file = &profiler->files[f];
+        for (int i = 0; i < file->capacity; i++) {
+            if (file->lines[i].count > 0) {
+                hot[n].file_index = f;
+                hot[n].line_number = i;
+                hot[n].line = &file->lines[i];
+                n++;
+            }
+        }
+    }
+    qsort(hot, n, sizeof(HotLine), profiler_compare_hot);
+    
+    fprintf(output, "\n=== Hottest lines (by self time) ===\n");
+    fprintf(output, "%-24s %6s %10s %12s %12s  %s\n", "file", "line", "count", "self ms", "total ms", "source");
+    for (long i = 0; i < n && i < limit; i++) {
+        char source[PROFILE_LINE_TEXT];
+        const char* filename = profiler->files[hot[i].file_index].filename;
+        profiler_read_source_line(filename, hot[i].line_number, source, sizeof(source));
+        
+        fprintf(output, "%-24s %6d %10ld %12.3f %12.3f  %s\n", filename, hot[i].line_number,
+                hot[i].line->count, hot[i].line->self_time * 1e3, hot[i].line->total_time * 1e3, source);
+    }
+    
+    free(hot);
+}
+
+// Запись аннотированных копий скриптов: <файл>.prof с колонками профиля
+int profiler_write_annotated(const Profiler* profiler) {
+    if (profiler == NULL) return -1;
+    
+    int result = 0;
+    for (int f = 0; f < profiler->file_count; f++) {
+        const FileProfile* file = &profiler->files[f];
+        char annotated_name[PROFILE_MAX_FILENAME + 8];
+        snprintf(annotated_name, sizeof(annotated_name), "%s.prof", file->filename);
+        
+        FILE* source = fopen(file->filename, "r");
+        if (source == NULL) {
+            printf("Error: Cannot reopen '%s' for annotation\n", file->filename);
+            result = -1;
+            continue;
+        }
+        FILE* output = fopen(annotated_name, "w");
+        if (output == NULL) {
+            printf("Error: Cannot create annotated file '%s'\n", annotated_name);
+            fclose(source);
+            result = -1;
+            continue;
+        }
+        
+        fprintf(output, "// %10s %12s %12s | source\n", "count", "self ms", "total ms");
+        char line[PROFILE_LINE_TEXT];
+        for (int i = 1; read_line(source, line, sizeof(line)) != NULL; i++) {
+            if (i < file->capacity && file->lines[i].count > 0) {
+                const LineProfile* profile = &file->lines[i];
+                fprintf(output, "   %10ld %12.3f %12.3f | %s\n", profile->count,
+                        profile->self_time * 1e3, profile->total_time * 1e3, line);
+            } else {
+                fprintf(output, "   %10s %12s %12s | %s\n", "", "", "", line);
+            }
+        }
+        
+        fclose(source);
+        fclose(output);
+        printf("Annotated profile saved to '%s'\n", annotated_name);
+    }
+    return result;
+}
@@ -0,0 +1,47 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdio.h>
+
+#define PROFILE_MAX_FILENAME 256
+#define PROFILE_HOT_LINES 20    // Сколько самых "горячих" строк выводить
+
+// Профиль одной строки скрипта
+typedef struct {
+    long count;             // Сколько раз выполнялась
+    double total_time;      // Полное время в секундах (с вложенными EXEC)
+    double self_time;       // Собственное время (без строк вложенных файлов)
+} LineProfile;
+
+// Профиль файла скрипта: массив строк, растет по мере надобности
+typedef struct {
+    char filename[PROFILE_MAX_FILENAME];
+    LineProfile* lines;     // Индекс - номер строки
+    int capacity;
+} FileProfile;
+
+// Профилировщик (--profile)
+typedef struct {
+    int enabled;
+    FileProfile* files;
+    int file_count;
+    int file_capacity;
+    double child_time;      // Время строк, выполненных внутри текущей строки
+} Profiler;
+
+// Отметка начала строки (хранится у вызывающего)
+typedef struct {
+    double start;
+    double saved_child_time;
+} ProfileMark;
+
+// Функции профилировщика
+void profiler_init(Profiler* profiler);
+void profiler_free(Profiler* profiler);
+int profiler_file_index(Profiler* profiler, const char* filename);
+void profiler_line_begin(Profiler* profiler, ProfileMark* mark);
+void profiler_line_end(Profiler* profiler, const ProfileMark* mark, int file_index, int line_number);
+void profiler_print_hot_lines(const Profiler* profiler, FILE* output, int limit);
+int profiler_write_annotated(const Profiler* profiler);
+
+#endif
@@ -0,0 +1,202 @@
+#include "scheduler.h"
+#include "utils.h"
+
+// Создание пустого планировщика
+Scheduler* scheduler_create(long quota) {
+    Scheduler* scheduler = calloc(1, sizeof(Scheduler));
+    if (scheduler == NULL) {
+        printf("Error: Cannot allocate scheduler\n");
+        return NULL;
+    }
+
+    scheduler->quota = quota > 0 ? quota : SCHEDULER_DEFAULT_QUOTA;
+    scheduler->scripts = script_cache_create();
+    if (scheduler->scripts == NULL) {
+        free(scheduler);
+        return NULL;
+    }
+    return scheduler;
+}
+
+// Освобождение сессий и их контекстов
+void scheduler_destroy(Scheduler* scheduler) {
+    if (scheduler == NULL) return;
+
+    for (int i = 0; i < scheduler->count; i++) {
+        interpreter_free(scheduler->sessions[i].context);
+        free(scheduler->sessions[i].context);
+    }
+    free(scheduler->sessions);
+    script_cache_destroy(scheduler->scripts);
+    free(scheduler);
+}
+
+// Новая сессия, выполняющая скрипт из файла
+int scheduler_add_session(Scheduler* scheduler, const char* script_filename) {
+    if (scheduler->count >= SCHEDULER_MAX_SESSIONS) {
+        printf("Error: Too many sessions (max %d)\n", SCHEDULER_MAX_SESSIONS);
+        return -1;
+    }
+    if (scheduler->count == scheduler->capacity) {
+        int capacity = scheduler->capacity ? scheduler->capacity * 2 : 64;
+        Session* sessions = realloc(scheduler->sessions, capacity * sizeof(Session));
+        if (sessions == NULL) {
+            printf("Error: Cannot allocate sessions\n");
+            return -1;
+        }
+        scheduler->sessions = sessions;
+        scheduler->capacity = capacity;
+    }
+
+    // Контекст без отображения: вывод сессий перемежается по квантам
+    InterpreterContext* context = malloc(sizeof(InterpreterContext));
+    if (context == NULL) {
+        printf("Error: Cannot allocate session context\n");
+        return -1;
+    }
+    interpreter_init(context);
+    interpreter_set_display_options(context, 0, 0.0);
+    interpreter_set_save_option(context, 0);
+    context->script_cache = scheduler->scripts;
+
+    if (interpreter_start_file(context, &scheduler->sessions[scheduler->count].state, script_filename) != 0) {
+        printf("Error: Cannot open file '%s'\n", script_filename);
+        free(context);
+        return -1;
+    }
+
+    Session* session = &scheduler->sessions[scheduler->count++];
+    session->context = context;
+    snprintf(session->filename, sizeof(session->filename), "%s", script_filename);
+    session->finished = 0;
+    session->lines = 0;
+    session->slices = 0;
+    return 0;
+}
+
+// Загрузка описания сессий: строки "SESSION file [count]"
+int scheduler_load(Scheduler* scheduler, const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return -1;
+    }
+
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int result = 0;
+
+    while (result == 0 && read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+        trim_whitespace(line);
+        if (line[0] == '\0' || is_comment_line(line)) {
+            continue;
+        }
+
+        char keyword[16];
+        char argument[MAX_FILENAME_LENGTH];
+        int copies = 1;
+        int fields = sscanf(line, "%15s %99s %d", keyword, argument, &copies);
+
+        if (fields >= 2 && strcasecmp(keyword, "SESSION") == 0 && copies >= 1) {
+            for (int i = 0; i < copies && result == 0; i++) {
+                result = scheduler_add_session(scheduler, argument);
+            }
+        } else {
+            printf("Syntax Error: line %d in %s must be SESSION file [count]\n", line_number, filename);
+            result = -2;
+        }
+
+        if (result != 0) {
+            printf("Error at line %d in %s\n", line_number, filename);
+        }
+    }
+
+    fclose(file);
+
+    if (result == 0) {
+        printf("Sessions loaded from '%s': %d sessions\n", filename, scheduler->count);
+    }
+    return result;
+}
+
+// Выполнение всех сессий по кругу до завершения. Возвращает число обработанных строк
+long scheduler_run(Scheduler* scheduler) {
+    int* active = malloc((scheduler->count + 1) * sizeof(int));
+    if (active == NULL) {
+        printf("Error: Cannot allocate run queue\n");
+        return -1;
+    }
+    int active_count = 0;
+    for (int i = 0; i < scheduler->count; i++) {
+        if (!scheduler->sessions[i].finished) {
+            active[active_count++] = i;
+        }
+    }
+
+    long total = 0;
+    while (active_count > 0) {
+        int kept = 0;
+        for (int i = 0; i < active_count; i++) {
+            Session* session = &scheduler->sessions[active[i]];
+            printf("--- Session %d: %s ---\n", active[i] + 1, session->filename);
+
+            long lines = interpreter_step(session->context, &session->state, scheduler->quota);
+            session->lines += lines;
+            session->slices++;
+            scheduler->slices++;
+            total += lines;
+
+            if (session->state.depth == 0) {
+                session->finished = 1;
+                printf("--- Session %d finished: %s ---\n", active[i] + 1,
+                       session->context->error_occurred ? "error" : "ok");
+            } else {
+                active[kept++] = active[i];
+            }
+        }
+        active_count = kept;
+    }
+
+    free(active);
+    return total;
+}
+
+// Итоги по сессиям
+void scheduler_print_summary(const Scheduler* scheduler, FILE* output) {
+    long lines = 0, commands = 0;
+    int failed = 0;
+
+    for (int i = 0; i < scheduler->count; i++) {
+        const Session* session = &scheduler->sessions[i];
+        lines += session->lines;
+        commands += session->context->commands_executed;
+        failed += session->context->error_occurred;
+
+        if (scheduler->count <= 20) {
+            fprintf(output, "Session %d (%s): %s, %ld commands in %ld slices\n", i + 1, session->filename,
+                    session->context->error_occurred ? "error" : "ok",
+                    session->context->commands_executed, session->slices);
+        }
+    }
+
+    fprintf(output, "Sessions: %d (%d failed), %ld lines, %ld commands, %ld slices of %ld lines\n",
+            scheduler->count, failed, lines, commands, scheduler->slices, scheduler->quota);
+}
+
+// Конечные поля всех сессий подряд
+void scheduler_print_fields(const Scheduler* scheduler, FILE* output, int rle) {
+    for (int i = 0; i < scheduler->count; i++) {
+        const Session* session = &scheduler->sessions[i];
+        fprintf(output, "=== Session %d: %s (%s) ===\n", i + 1, session->filename,
+                session->context->error_occurred ? "error" : "ok");
+        if (!session->context->field_initialized) {
+            continue;
+        }
+        if (rle) {
+            field_print_rle(&session->context->field, output);
+        } else {
+            field_print(&session->context->field, output);
+        }
+    }
+}
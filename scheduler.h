@@ -0,0 +1,38 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "interpreter.h"
+
+#define SCHEDULER_DEFAULT_QUOTA 16      // Строк скрипта за один квант сессии
+#define SCHEDULER_MAX_SESSIONS 100000
+
+// Сессия: свой контекст интерпретатора и свой стек EXEC
+typedef struct {
+    InterpreterContext* context;
+    ExecState state;
+    char filename[MAX_FILENAME_LENGTH];
+    int finished;
+    long lines;                 // Обработано строк скрипта
+    long slices;                // Получено квантов
+} Session;
+
+// Планировщик сессий: в одном потоке сессии по кругу получают квант из quota строк
+typedef struct {
+    Session* sessions;
+    int count;
+    int capacity;
+    long quota;
+    ScriptCache* scripts;       // Разобранные скрипты, общие для всех сессий
+    long slices;
+} Scheduler;
+
+// Функции планировщика
+Scheduler* scheduler_create(long quota);
+void scheduler_destroy(Scheduler* scheduler);
+int scheduler_load(Scheduler* scheduler, const char* filename);
+int scheduler_add_session(Scheduler* scheduler, const char* script_filename);
+long scheduler_run(Scheduler* scheduler);
+void scheduler_print_summary(const Scheduler* scheduler, FILE* output);
+void scheduler_print_fields(const Scheduler* scheduler, FILE* output, int rle);
+
+#endif
@@ -0,0 +1,145 @@
+#include "scriptcache.h"
+#include "utils.h"
+
+// Разбор всех строк файла. Сообщения парсера об ошибках при этом не выводятся:
+// строки с ошибками разбираются повторно во время выполнения
+int script_parse(FILE* file, ParsedScript* script) {
+    char line[MAX_LINE_LENGTH];
+    int line_number = 0;
+    int capacity = 0;
+
+    script->lines = NULL;
+    script->count = 0;
+    script->pins = 0;
+
+    // parse_line печатает ошибки - на время разбора вывод отключается
+    fflush(stdout);
+    FILE* saved_stdout = stdout;
+    FILE* null_output = fopen("/dev/null", "w");
+    if (null_output != NULL) {
+        stdout = null_output;
+    }
+
+    int result = 0;
+    while (read_line(file, line, sizeof(line)) != NULL) {
+        line_number++;
+
+        ParsedCommand cmd;
+        int parsed = (parse_line(line, &cmd) == 0);
+        if (parsed && cmd.type == CMD_COMMENT) {
+            continue;
+        }
+
+        if (script->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            ScriptLine* lines = realloc(script->lines, capacity * sizeof(ScriptLine));
+            if (lines == NULL) {
+                result = -1;
+                break;
+            }
+            script->lines = lines;
+        }
+
+        ScriptLine* entry = &script->lines[script->count++];
+        entry->line_number = line_number;
+        entry->parsed = parsed;
+        entry->cmd = cmd;
+        strcpy(entry->text, line);
+    }
+
+    if (null_output != NULL) {
+        stdout = saved_stdout;
+        fclose(null_output);
+    }
+    if (result != 0) {
+        printf("Error: Cannot allocate memory for script\n");
+        script_free(script);
+    }
+    return result;
+}
+
+void script_free(ParsedScript* script) {
+    free(script->lines);
+    script->lines = NULL;
+    script->count = 0;
+}
+
+ScriptCache* script_cache_create(void) {
+    ScriptCache* cache = calloc(1, sizeof(ScriptCache));
+    if (cache == NULL) {
+        printf("Error: Cannot allocate script cache\n");
+    }
+    return cache;
+}
+
+void script_cache_destroy(ScriptCache* cache) {
+    if (cache == NULL) return;
+    for (int i = 0; i < cache->count; i++) {
+        script_free(&cache->entries[i]);
+    }
+    free(cache);
+}
+
+// Разобранный файл из кэша; NULL, если файл не открывается
+ParsedScript* script_cache_get(ScriptCache* cache, const char* filename) {
+    ParsedScript* entry = NULL;
+    for (int i = 0; i < cache->count; i++) {
+        if (strcmp(cache->entries[i].filename, filename) == 0) {
+            entry = &cache->entries[i];
+            break;
+        }
+    }
+    if (entry != NULL && file_stamp_same(filename, &entry->stamp)) {
+        cache->hits++;
+        entry->last_used = ++cache->clock;
+        return entry;
+    }
+
+    FileStamp stamp;
+    if (file_stamp_get(filename, &stamp) != 0) {
+        return NULL;
+    }
+    cache->clock++;
+
+    // Устаревший файл, который еще выполняется, остается до освобождения, но больше не находится
+    if (entry != NULL && entry->pins > 0) {
+        entry->filename[0] = '\0';
+        entry = NULL;
+    }
+
+    // Новый файл вытесняет давно не использованный (закрепленные не вытесняются)
+    if (entry == NULL) {
+        if (cache->count < SCRIPT_CACHE_SIZE) {
+            entry = &cache->entries[cache->count++];
+        } else {
+            for (int i = 0; i < cache->count; i++) {
+                ParsedScript* candidate = &cache->entries[i];
+                if (candidate->pins == 0 && (entry == NULL || candidate->last_used < entry->last_used)) {
+                    entry = candidate;
+                }
+            }
+            if (entry == NULL) {
+                return NULL;  // Все файлы выполняются - вызывающий читает файл сам
+            }
+        }
+    }
+    script_free(entry);
+    cache->misses++;
+
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        entry->filename[0] = '\0';
+        return NULL;
+    }
+    int result = script_parse(file, entry);
+    fclose(file);
+    if (result != 0) {
+        entry->filename[0] = '\0';
+        return NULL;
+    }
+
+    snprintf(entry->filename, sizeof(entry->filename), "%s", filename);
+    entry->stamp = stamp;
+    entry->last_used = cache->clock;
+    return entry;
+}
@@ -0,0 +1,43 @@
+#ifndef SCRIPTCACHE_H
+#define SCRIPTCACHE_H
+
+#include "parser.h"
+#include "utils.h"
+
+#define SCRIPT_CACHE_SIZE 64    // Файлов в кэше
+
+// Строка скрипта после разбора (комментарии и пустые строки не хранятся)
+typedef struct {
+    int line_number;
+    int parsed;                 // 0 - ошибка разбора, строка разбирается заново для сообщения
+    ParsedCommand cmd;
+    char text[MAX_LINE_LENGTH];
+} ScriptLine;
+
+// Разобранный файл скрипта
+typedef struct {
+    char filename[256];
+    FileStamp stamp;            // Состояние файла при разборе
+    unsigned long long last_used;
+    int pins;                   // Сколько кадров выполнения используют файл (не вытесняется)
+    ScriptLine* lines;
+    int count;
+} ParsedScript;
+
+// Кэш разобранных файлов (--serve): файл разбирается заново, только если изменился
+typedef struct {
+    ParsedScript entries[SCRIPT_CACHE_SIZE];
+    int count;
+    unsigned long long clock;
+    long hits;
+    long misses;
+} ScriptCache;
+
+// Функции кэша скриптов
+int script_parse(FILE* file, ParsedScript* script);
+void script_free(ParsedScript* script);
+ScriptCache* script_cache_create(void);
+void script_cache_destroy(ScriptCache* cache);
+ParsedScript* script_cache_get(ScriptCache* cache, const char* filename);
+
+#endif
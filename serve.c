@@ -0,0 +1,349 @@
+#include "serve.h"
+#include "ctxpool.h"
+#include "utils.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Задание, полученное от клиента
+typedef struct {
+    char script_path[256];
+    char* script_text;          // NULL - скрипт задан путем
+    size_t script_length;
+    char* field_text;           // NULL - начального поля нет
+    size_t field_length;
+    int rle;
+} ServeJob;
+
+static volatile sig_atomic_t serve_stop = 0;
+
+static void serve_handle_signal(int signal_number) {
+    (void)signal_number;
+    serve_stop = 1;
+}
+
+// Чтение n байт данных после строки заголовка
+static char* serve_read_payload(FILE* input, const char* length_text, size_t* length) {
+    long value = atol(length_text);
+    if (value < 0 || value > SERVE_MAX_PAYLOAD) {
+        return NULL;
+    }
+    char* payload = malloc(value + 1);
+    if (payload == NULL) {
+        return NULL;
+    }
+    if (fread(payload, 1, value, input) != (size_t)value) {
+        free(payload);
+        return NULL;
+    }
+    payload[value] = '\0';
+    *length = value;
+    return payload;
+}
+
+static void serve_free_job(ServeJob* job) {
+    free(job->script_text);
+    free(job->field_text);
+}
+
+// Чтение запроса прервано SO_RCVTIMEO
+static int serve_timed_out(FILE* input) {
+    return ferror(input) && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+// Разбор запроса. Возвращает NULL при успехе или текст ошибки
+static const char* serve_read_job(FILE* input, ServeJob* job) {
+    char line[MAX_LINE_LENGTH + 32];
+    memset(job, 0, sizeof(ServeJob));
+
+    while (read_line(input, line, sizeof(line)) != NULL) {
+        size_t length = strlen(line);
+        if (length > 0 && line[length - 1] == '\r') {
+            line[length - 1] = '\0';
+        }
+
+        if (strcmp(line, "RUN") == 0) {
+            if (job->script_text == NULL && job->script_path[0] == '\0') {
+                return "no SCRIPT or SCRIPT-TEXT in request";
+            }
+            return NULL;
+        } else if (strncmp(line, "SCRIPT ", 7) == 0) {
+            if (strlen(line + 7) >= sizeof(job->script_path)) {
+                return "SCRIPT path too long";
+            }
+            strcpy(job->script_path, line + 7);
+        } else if (strncmp(line, "SCRIPT-TEXT ", 12) == 0) {
+            free(job->script_text);
+            job->script_text = serve_read_payload(input, line + 12, &job->script_length);
+            if (job->script_text == NULL) {
+                return serve_timed_out(input) ? "request timeout" : "cannot read SCRIPT-TEXT data";
+            }
+        } else if (strncmp(line, "FIELD ", 6) == 0) {
+            free(job->field_text);
+            job->field_text = serve_read_payload(input, line + 6, &job->field_length);
+            if (job->field_text == NULL) {
+                return serve_timed_out(input) ? "request timeout" : "cannot read FIELD data";
+            }
+        } else if (strcmp(line, "OPTION rle") == 0) {
+            job->rle = 1;
+        } else if (line[0] != '\0') {
+            return "unknown request line";
+        }
+    }
+    return serve_timed_out(input) ? "request timeout" : "request not terminated by RUN";
+}
+
+// Выполнение задания; вывод интерпретатора идет в stdout (перенаправлен в файл)
+static void serve_execute(InterpreterContext* context, ScriptCache* scripts, const ServeJob* job) {
+    if (job->field_text != NULL) {
+        FILE* field_file = fmemopen(job->field_text, job->field_length, "r");
+        if (field_file == NULL || field_load_from_stream(&context->field, field_file, "<request>") != 0) {
+            context->error_occurred = 1;
+            strcpy(context->error_message, "Invalid initial field");
+        } else {
+            context->field_initialized = 1;
+            if (context->field.dino_x != -1 && context->field.dino_y != -1) {
+                context->dino_placed = 1;
+            }
+        }
+        if (field_file != NULL) {
+            fclose(field_file);
+        }
+        if (context->error_occurred) {
+            return;
+        }
+    }
+
+    if (job->script_text != NULL) {
+        ParsedScript script;
+        FILE* script_file = fmemopen(job->script_text, job->script_length, "r");
+        if (script_file == NULL || script_parse(script_file, &script) != 0) {
+            printf("Error: Cannot read script text\n");
+            context->error_occurred = 1;
+        } else {
+            interpreter_execute_parsed(context, &script);
+            script_free(&script);
+        }
+        if (script_file != NULL) {
+            fclose(script_file);
+        }
+    } else {
+        ParsedScript* script = script_cache_get(scripts, job->script_path);
+        if (script == NULL) {
+            printf("Error: Cannot open input file '%s'\n", job->script_path);
+            context->error_occurred = 1;
+        } else {
+            interpreter_execute_parsed(context, script);
+        }
+    }
+
+    if (!context->error_occurred) {
+        printf("Program executed successfully!\n");
+    }
+}
+
+// Отправка блока "NAME n\n" + данные
+static void serve_write_block(FILE* output, const char* name, const char* data, size_t length) {
+    fprintf(output, "%s %zu\n", name, length);
+    fwrite(data, 1, length, output);
+}
+
+// Обработка одного соединения
+static void serve_connection(ContextPool* pool, ScriptCache* scripts, int connection) {
+    // Молчащий клиент не занимает рабочий процесс дольше SERVE_REQUEST_TIMEOUT
+    struct timeval timeout = { SERVE_REQUEST_TIMEOUT, 0 };
+    setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    FILE* input = fdopen(dup(connection), "r");
+    FILE* output = fdopen(dup(connection), "w");
+    if (input == NULL || output == NULL) {
+        if (input != NULL) fclose(input);
+        if (output != NULL) fclose(output);
+        return;
+    }
+
+    ServeJob job;
+    const char* request_error = serve_read_job(input, &job);
+    if (request_error != NULL) {
+        fprintf(output, "STATUS error %s\n", request_error);
+        serve_free_job(&job);
+        fclose(input);
+        fclose(output);
+        return;
+    }
+
+    // Прогретый контекст: кэши путей и индексы символов переживают задания
+    InterpreterContext* context = context_pool_acquire(pool);
+    if (context == NULL) {
+        fprintf(output, "STATUS error cannot allocate context\n");
+        serve_free_job(&job);
+        fclose(input);
+        fclose(output);
+        return;
+    }
+    interpreter_set_display_options(context, 0, 0.0);
+    interpreter_set_save_option(context, 0);
+    context->script_cache = scripts;
+
+    // Вывод интерпретатора на время задания собирается во временный файл
+    FILE* capture = tmpfile();
+    int saved_stdout = -1;
+    if (capture != NULL) {
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        dup2(fileno(capture), STDOUT_FILENO);
+    }
+
+    serve_execute(context, scripts, &job);
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+
+    // Вывод интерпретатора
+    char* captured = NULL;
+    size_t captured_length = 0;
+    if (capture != NULL) {
+        long length = ftell(capture);
+        captured = malloc(length > 0 ? length : 1);
+        if (captured != NULL && length > 0) {
+            fseek(capture, 0, SEEK_SET);
+            captured_length = fread(captured, 1, length, capture);
+        }
+        fclose(capture);
+    }
+    serve_write_block(output, "OUTPUT", captured != NULL ? captured : "", captured_length);
+    free(captured);
+
+    // Конечное поле в том же виде, что и выходной файл
+    if (context->field_initialized) {
+        char* field_text = NULL;
+        size_t field_length = 0;
+        FILE* field_output = open_memstream(&field_text, &field_length);
+        if (field_output != NULL) {
+            if (job.rle) {
+                field_print_rle(&context->field, field_output);
+            } else {
+                field_print(&context->field, field_output);
+            }
+            fclose(field_output);
+            serve_write_block(output, "FIELD", field_text, field_length);
+            free(field_text);
+        }
+    }
+
+    fprintf(output, "STATUS %s\n", context->error_occurred ? "error" : "ok");
+    context_pool_release(pool, context);
+    serve_free_job(&job);
+    fclose(input);
+    fclose(output);
+}
+
+// Рабочий процесс: пул контекстов и кэш скриптов на все задания
+static void serve_worker(int listen_fd) {
+    ContextPool* pool = context_pool_create();
+    ScriptCache* scripts = script_cache_create();
+    if (pool == NULL || scripts == NULL) {
+        exit(1);
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    while (1) {
+        int connection = accept(listen_fd, NULL, NULL);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        serve_connection(pool, scripts, connection);
+        close(connection);
+    }
+    exit(1);
+}
+
+static pid_t serve_spawn(int listen_fd) {
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        serve_worker(listen_fd);
+    }
+    return pid;
+}
+
+// Запуск сервера: пул из workers процессов, каждый принимает соединения сам
+int serve_run(const char* socket_path, int workers) {
+    if (workers < 1) workers = 1;
+    if (workers > SERVE_MAX_WORKERS) workers = SERVE_MAX_WORKERS;
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path '%s' is too long\n", socket_path);
+        return -1;
+    }
+    strcpy(address.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        printf("Error: Cannot create socket: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(socket_path);
+    if (bind(listen_fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listen_fd, SOMAXCONN) != 0) {
+        printf("Error: Cannot listen on '%s': %s\n", socket_path, strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    // Обрыв соединения клиентом не должен завершать процесс
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = serve_handle_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    pid_t pids[SERVE_MAX_WORKERS];
+    for (int i = 0; i < workers; i++) {
+        pids[i] = serve_spawn(listen_fd);
+    }
+    printf("Serving on '%s' with %d workers\n", socket_path, workers);
+    fflush(stdout);
+
+    // Упавший рабочий процесс заменяется новым
+    while (!serve_stop) {
+        pid_t pid = wait(NULL);
+        if (pid < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (int i = 0; i < workers; i++) {
+            if (pids[i] == pid && !serve_stop) {
+                pids[i] = serve_spawn(listen_fd);
+            }
+        }
+    }
+
+    for (int i = 0; i < workers; i++) {
+        if (pids[i] > 0) {
+            kill(pids[i], SIGTERM);
+        }
+    }
+    while (wait(NULL) > 0) {
+    }
+    close(listen_fd);
+    unlink(socket_path);
+    printf("Server stopped\n");
+    return 0;
+}
@@ -0,0 +1,28 @@
+#ifndef SERVE_H
+#define SERVE_H
+
+// Режим сервера (--serve): задания принимаются через Unix-сокет.
+//
+// Запрос (одно задание на соединение), строки заголовка до RUN:
+//   SCRIPT path         - скрипт на диске сервера (разбор кэшируется)
+//   SCRIPT-TEXT n       - текст скрипта, следом n байт
+//   FIELD n             - начальное поле (как для LOAD, обычное или RLE), следом n байт
+//   OPTION rle          - вернуть поле в формате RLE
+//   RUN                 - выполнить задание
+//
+// Ответ:
+//   OUTPUT n            - вывод интерпретатора (сообщения, предупреждения, ошибки), следом n байт
+//   FIELD n             - конечное поле, следом n байт (если поле было задано)
+//   STATUS ok|error
+//
+// Если клиент молчит дольше SERVE_REQUEST_TIMEOUT секунд до RUN, ответ -
+// STATUS error request timeout (рабочий процесс не ждет его бесконечно)
+
+#define SERVE_MAX_PAYLOAD (16 * 1024 * 1024)    // Максимальный размер скрипта или поля в запросе
+#define SERVE_MAX_WORKERS 256
+#define SERVE_REQUEST_TIMEOUT 5                 // Секунд ожидания данных запроса
+
+// Функции сервера
+int serve_run(const char* socket_path, int workers);
+
+#endif
@@ -0,0 +1,719 @@
+#include "solve.h"
+#include "field.h"
+#include "commands.h"
+#include "utils.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <strings.h>
+
+#define SOLVE_MAX_MOVES 80
+#define SOLVE_BLOCK_SIZE (1 << 20)      // Блок арены
+#define SOLVE_CHUNK 64                  // Состояний за одну выборку из очереди
+#define SOLVE_MIN_SEEN (1 << 16)        // Наименьшая таблица хешей состояний
+
+// Клетка состояния - байт: тип (3 младших бита) и цвет (0 - нет, 1..26 - 'a'..'z')
+#define SOLVE_TYPE(cell) ((cell) & 7)
+#define SOLVE_COLOR(cell) ((cell) >> 3)
+
+enum { SOLVE_EMPTY, SOLVE_DINO, SOLVE_HOLE, SOLVE_MOUNTAIN, SOLVE_TREE, SOLVE_STONE };
+static const char solve_type_symbols[] = { CELL_EMPTY, CELL_DINO, CELL_HOLE, CELL_MOUNTAIN, CELL_TREE, CELL_STONE };
+static const char* const solve_direction_names[] = { "UP", "DOWN", "LEFT", "RIGHT" };
+
+// Команда перебора
+typedef struct {
+    CommandType type;
+    int dx, dy;
+    int n;                      // Длина JUMP
+    char color;                 // Цвет PAINT
+    char text[24];              // Строка команды для скрипта
+} SolveMove;
+
+// Состояние поиска. Клетки лежат в арене своего уровня и освобождаются после
+// его раскрытия; для восстановления скрипта нужны только parent и move
+typedef struct SolveNode {
+    const struct SolveNode* parent;
+    unsigned char* cells;       // По столбцам, как grid[x][y]
+    unsigned char dino_x, dino_y;
+    unsigned char move;         // Команда, которой состояние получено из parent
+} SolveNode;
+
+typedef struct SolveBlock {
+    struct SolveBlock* next;
+    size_t used;
+    unsigned char data[];
+} SolveBlock;
+
+// Арена: цепочка блоков, после сброса блоки используются заново
+typedef struct {
+    SolveBlock* first;
+    SolveBlock* current;
+} SolveArena;
+
+struct Solver;
+
+// Поток поиска. Очередь текущего уровня общая: закончив свою, поток забирает
+// куски чужих очередей через их курсоры
+typedef struct {
+    struct Solver* solver;
+    int id;
+    SolveArena nodes;           // Заголовки состояний всех уровней
+    SolveArena cells[2];        // Клетки текущего и следующего уровня
+    SolveNode** frontier;
+    long frontier_count;
+    _Atomic long cursor;        // Следующее невзятое состояние очереди
+    SolveNode** next;           // Новые состояния следующего уровня
+    long next_count;
+    long next_capacity;
+    long frontier_capacity;
+} SolveWorker;
+
+typedef struct Solver {
+    int width, height;
+    int size;                               // Клеток в состоянии
+    char target[MAX_WIDTH * MAX_HEIGHT];    // Символы целевого поля (по столбцам)
+    SolveMove moves[SOLVE_MAX_MOVES];
+    int move_count;
+
+    // Множество хешей встреченных состояний (открытая адресация, 0 - свободно)
+    _Atomic uint64_t* seen;
+    size_t seen_mask;
+    long seen_limit;                        // Заполнение, после которого поиск останавливается
+    _Atomic long seen_count;
+
+    size_t memory_limit;
+    _Atomic size_t memory_used;
+    atomic_int out_of_memory;
+
+    SolveWorker workers[SOLVE_MAX_THREADS];
+    int thread_count;
+    int level;                              // Глубина раскрываемого уровня
+    _Atomic(const SolveNode*) found;
+} Solver;
+
+// Учет памяти поиска: -1, если ограничение превышено (поиск останавливается)
+static int solve_reserve(Solver* solver, size_t bytes) {
+    size_t used = atomic_fetch_add(&solver->memory_used, bytes) + bytes;
+    if (used > solver->memory_limit) {
+        atomic_fetch_sub(&solver->memory_used, bytes);
+        atomic_store(&solver->out_of_memory, 1);
+        return -1;
+    }
+    return 0;
+}
+
+static void* solve_arena_alloc(Solver* solver, SolveArena* arena, size_t size) {
+    size = (size + 7) & ~(size_t)7;
+    size_t capacity = SOLVE_BLOCK_SIZE - sizeof(SolveBlock);
+
+    SolveBlock* block = arena->current;
+    if (block == NULL || block->used + size > capacity) {
+        if (block != NULL && block->next != NULL) {
+            block = block->next;
+        } else {
+            if (solve_reserve(solver, SOLVE_BLOCK_SIZE) != 0) {
+                return NULL;
+            }
+            SolveBlock* fresh = malloc(SOLVE_BLOCK_SIZE);
+            if (fresh == NULL) {
+                atomic_store(&solver->out_of_memory, 1);
+                return NULL;
+            }
+            fresh->next = NULL;
+            if (block != NULL) {
+                block->next = fresh;
+            } else {
+                arena->first = fresh;
+            }
+            block = fresh;
+        }
+        block->used = 0;
+        arena->current = block;
+    }
+
+    void* pointer = block->data + block->used;
+    block->used += size;
+    return pointer;
+}
+
+static void solve_arena_reset(SolveArena* arena) {
+    arena->current = arena->first;
+    if (arena->first != NULL) {
+        arena->first->used = 0;
+    }
+}
+
+static void solve_arena_free(SolveArena* arena) {
+    SolveBlock* block = arena->first;
+    while (block != NULL) {
+        SolveBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+// Хеш клеток состояния (положение динозавра входит через тип его клетки)
+static uint64_t solve_hash(const unsigned char* cells, int size) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL;
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, cells + i, sizeof(word));
+        hash = (hash ^ word) * 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 32;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ cells[i]) * 0x100000001B3ULL;
+    }
+    hash ^= hash >> 29;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 32;
+    return hash != 0 ? hash : 1;
+}
+
+// Добавление хеша в множество: 1 - состояние новое, 0 - уже встречалось
+static int solve_seen_insert(Solver* solver, uint64_t hash) {
+    size_t i = hash & solver->seen_mask;
+    for (;;) {
+        uint64_t current = atomic_load_explicit(&solver->seen[i], memory_order_relaxed);
+        if (current == hash) {
+            return 0;
+        }
+        if (current == 0) {
+            uint64_t expected = 0;
+            if (atomic_compare_exchange_strong_explicit(&solver->seen[i], &expected, hash,
+                                                        memory_order_relaxed, memory_order_relaxed)) {
+                if (atomic_fetch_add_explicit(&solver->seen_count, 1, memory_order_relaxed) >= solver->seen_limit) {
+                    atomic_store(&solver->out_of_memory, 1);
+                }
+                return 1;
+            }
+            if (expected == hash) {
+                return 0;
+            }
+        }
+        i = (i + 1) & solver->seen_mask;
+    }
+}
+
+// Свойства типа клетки состояния (cell_properties по символу типа)
+static inline uint16_t solve_flags(int type) {
+    return cell_flags((CellType)solve_type_symbols[type]);
+}
+
+static void solve_set_type(unsigned char* cells, int index, int type) {
+    cells[index] = (unsigned char)((cells[index] & ~7) | type);
+}
+
+static char solve_symbol(unsigned char cell) {
+    return SOLVE_COLOR(cell) ? (char)('a' + SOLVE_COLOR(cell) - 1) : solve_type_symbols[SOLVE_TYPE(cell)];
+}
+
+// Выполнение команды над состоянием по правилам field_*: 1 - получено новое
+// состояние в dst (x, y - динозавр), 0 - команда без эффекта или падение в яму
+static int solve_apply(const Solver* solver, const SolveMove* move, const SolveNode* node,
+                       unsigned char* dst, int* x, int* y) {
+    const unsigned char* src = node->cells;
+    int width = solver->width;
+    int height = solver->height;
+    int dino = node->dino_x * height + node->dino_y;
+    int tx = (node->dino_x + move->dx + width) % width;
+    int ty = (node->dino_y + move->dy + height) % height;
+    int target = tx * height + ty;
+    int type = SOLVE_TYPE(src[target]);
+
+    *x = node->dino_x;
+    *y = node->dino_y;
+
+    switch (move->type) {
+        case CMD_MOVE:
+            if (solve_flags(type) & (CELL_FLAG_FATAL | CELL_FLAG_BLOCKS)) {
+                return 0;
+            }
+            break;
+
+        case CMD_JUMP: {
+            int distance = move->n;
+            for (int i = 1; i <= move->n; i++) {
+                int cx = (node->dino_x + move->dx * i + width * i) % width;
+                int cy = (node->dino_y + move->dy * i + height * i) % height;
+                uint16_t check = solve_flags(SOLVE_TYPE(src[cx * height + cy]));
+                if (check & CELL_FLAG_BLOCKS) {
+                    distance = i - 1;  // Прыжок до препятствия
+                    break;
+                }
+                if (i == move->n && (check & CELL_FLAG_FATAL)) {
+                    return 0;
+                }
+            }
+            if (distance == 0) {
+                return 0;
+            }
+            tx = (node->dino_x + move->dx * distance + width * distance) % width;
+            ty = (node->dino_y + move->dy * distance + height * distance) % height;
+            target = tx * height + ty;
+            break;
+        }
+
+        case CMD_PAINT:
+            if (SOLVE_COLOR(src[dino]) == move->color - 'a' + 1) {
+                return 0;
+            }
+            memcpy(dst, src, solver->size);
+            dst[dino] = (unsigned char)((dst[dino] & 7) | ((move->color - 'a' + 1) << 3));
+            return 1;
+
+        case CMD_DIG: case CMD_MOUND: case CMD_GROW: case CMD_MAKE:
+            if (!(solve_flags(type) & CELL_FLAG_BUILDABLE)) {
+                return 0;
+            }
+            memcpy(dst, src, solver->size);
+            solve_set_type(dst, target, (move->type == CMD_DIG) ? SOLVE_HOLE :
+                                        (move->type == CMD_MOUND) ? SOLVE_MOUNTAIN :
+                                        (move->type == CMD_GROW) ? SOLVE_TREE : SOLVE_STONE);
+            return 1;
+
+        case CMD_CUT:
+            if (!(solve_flags(type) & CELL_FLAG_CUTTABLE)) {
+                return 0;
+            }
+            memcpy(dst, src, solver->size);
+            solve_set_type(dst, target, SOLVE_EMPTY);
+            return 1;
+
+        case CMD_PUSH: {
+            if (!(solve_flags(type) & CELL_FLAG_PUSHABLE)) {
+                return 0;
+            }
+            int sx = (tx + move->dx + width) % width;
+            int sy = (ty + move->dy + height) % height;
+            int destination = sx * height + sy;
+            uint16_t destination_flags = solve_flags(SOLVE_TYPE(src[destination]));
+            if (destination_flags & (CELL_FLAG_STOPS_PUSH | CELL_FLAG_BOUNCES_PUSH)) {
+                return 0;  // Препятствие или отскок от дерева
+            }
+            memcpy(dst, src, solver->size);
+            solve_set_type(dst, target, SOLVE_EMPTY);
+            solve_set_type(dst, destination, (destination_flags & CELL_FLAG_FILLED_BY_PUSH) ? SOLVE_EMPTY : type);
+            return 1;
+        }
+
+        default:
+            return 0;
+    }
+
+    // MOVE и JUMP: динозавр переходит в target
+    memcpy(dst, src, solver->size);
+    solve_set_type(dst, dino, SOLVE_EMPTY);
+    solve_set_type(dst, target, SOLVE_DINO);
+    *x = tx;
+    *y = ty;
+    return 1;
+}
+
+static int solve_is_target(const Solver* solver, const unsigned char* cells) {
+    for (int i = 0; i < solver->size; i++) {
+        if (solve_symbol(cells[i]) != solver->target[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Добавление состояния в очередь следующего уровня
+static int solve_push(Solver* solver, SolveWorker* worker, SolveNode* node) {
+    if (worker->next_count == worker->next_capacity) {
+        long capacity = worker->next_capacity ? worker->next_capacity * 2 : 1024;
+        if (solve_reserve(solver, (capacity - worker->next_capacity) * sizeof(SolveNode*)) != 0) {
+            return -1;
+        }
+        SolveNode** next = realloc(worker->next, capacity * sizeof(SolveNode*));
+        if (next == NULL) {
+            atomic_store(&solver->out_of_memory, 1);
+            return -1;
+        }
+        worker->next = next;
+        worker->next_capacity = capacity;
+    }
+    worker->next[worker->next_count++] = node;
+    return 0;
+}
+
+// Новое состояние: -1, если поиск нужно остановить
+static int solve_add(Solver* solver, SolveWorker* worker, const SolveNode* parent, int move,
+                     const unsigned char* cells, int x, int y) {
+    SolveNode* node = solve_arena_alloc(solver, &worker->nodes, sizeof(SolveNode));
+    unsigned char* copy = (node != NULL) ?
+        solve_arena_alloc(solver, &worker->cells[(solver->level + 1) & 1], solver->size) : NULL;
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, cells, solver->size);
+    node->parent = parent;
+    node->cells = copy;
+    node->dino_x = (unsigned char)x;
+    node->dino_y = (unsigned char)y;
+    node->move = (unsigned char)move;
+
+    if (solve_is_target(solver, copy)) {
+        const SolveNode* expected = NULL;
+        atomic_compare_exchange_strong(&solver->found, &expected, node);
+        return -1;
+    }
+    return solve_push(solver, worker, node);
+}
+
+static int solve_stopped(Solver* solver) {
+    return atomic_load_explicit(&solver->found, memory_order_relaxed) != NULL ||
+           atomic_load_explicit(&solver->out_of_memory, memory_order_relaxed);
+}
+
+// Раскрытие одного уровня: сначала своя очередь, потом чужие
+static void* solve_worker(void* arg) {
+    SolveWorker* worker = arg;
+    Solver* solver = worker->solver;
+    unsigned char cells[MAX_WIDTH * MAX_HEIGHT];
+
+    for (int k = 0; k < solver->thread_count; k++) {
+        SolveWorker* victim = &solver->workers[(worker->id + k) % solver->thread_count];
+        for (;;) {
+            if (solve_stopped(solver)) {
+                return NULL;
+            }
+            long begin = atomic_fetch_add(&victim->cursor, SOLVE_CHUNK);
+            if (begin >= victim->frontier_count) {
+                break;
+            }
+            long end = begin + SOLVE_CHUNK < victim->frontier_count ? begin + SOLVE_CHUNK : victim->frontier_count;
+            for (long i = begin; i < end; i++) {
+                const SolveNode* node = victim->frontier[i];
+                for (int m = 0; m < solver->move_count; m++) {
+                    int x, y;
+                    if (!solve_apply(solver, &solver->moves[m], node, cells, &x, &y) ||
+                        !solve_seen_insert(solver, solve_hash(cells, solver->size))) {
+                        continue;
+                    }
+                    if (solve_add(solver, worker, node, m, cells, x, y) != 0) {
+                        return NULL;
+                    }
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+// Переход к следующему уровню: новые очереди становятся текущими. Возвращает размер уровня
+static long solve_next_level(Solver* solver) {
+    long total = 0;
+    for (int t = 0; t < solver->thread_count; t++) {
+        SolveWorker* worker = &solver->workers[t];
+        SolveNode** frontier = worker->frontier;
+        long capacity = worker->frontier_capacity;
+        worker->frontier = worker->next;
+        worker->frontier_capacity = worker->next_capacity;
+        worker->frontier_count = worker->next_count;
+        worker->next = frontier;
+        worker->next_capacity = capacity;
+        worker->next_count = 0;
+        atomic_store(&worker->cursor, 0);
+        total += worker->frontier_count;
+    }
+    return total;
+}
+
+static void solve_expand_level(Solver* solver) {
+    if (solver->thread_count == 1) {
+        solve_worker(&solver->workers[0]);
+        return;
+    }
+
+    pthread_t handles[SOLVE_MAX_THREADS];
+    int created = 0;
+    for (int t = 1; t < solver->thread_count; t++) {
+        if (pthread_create(&handles[t], NULL, solve_worker, &solver->workers[t]) != 0) {
+            break;
+        }
+        created = t;
+    }
+    solve_worker(&solver->workers[0]);  // Очереди несозданных потоков забираются другими
+    for (int t = 1; t <= created; t++) {
+        pthread_join(handles[t], NULL);
+    }
+}
+
+static int solve_add_move(Solver* solver, CommandType type, int direction, int n, char color) {
+    if (solver->move_count == SOLVE_MAX_MOVES) {
+        return -1;
+    }
+    SolveMove* move = &solver->moves[solver->move_count++];
+    memset(move, 0, sizeof(SolveMove));
+    move->type = type;
+    move->n = n;
+    move->color = color;
+    if (type == CMD_PAINT) {
+        snprintf(move->text, sizeof(move->text), "PAINT %c", color);
+    } else {
+        get_direction_offset((Direction)direction, &move->dx, &move->dy);
+        if (type == CMD_JUMP) {
+            snprintf(move->text, sizeof(move->text), "JUMP %s %d", solve_direction_names[direction], n);
+        } else {
+            snprintf(move->text, sizeof(move->text), "%s %s", command_type_name(type),
+                     solve_direction_names[direction]);
+        }
+    }
+    return 0;
+}
+
+// Набор команд перебора. PAINT - только цветами целевого поля: другой цвет
+// все равно пришлось бы закрасить
+static int solve_build_moves(Solver* solver, const char* commands) {
+    static const CommandType types[] = { CMD_MOVE, CMD_PUSH, CMD_JUMP, CMD_CUT, CMD_DIG,
+                                         CMD_MOUND, CMD_GROW, CMD_MAKE, CMD_PAINT };
+    int count = sizeof(types) / sizeof(types[0]);
+    int enabled[sizeof(types) / sizeof(types[0])];
+
+    for (int i = 0; i < count; i++) {
+        enabled[i] = (commands == NULL);
+    }
+    if (commands != NULL) {
+        char list[256];
+        snprintf(list, sizeof(list), "%s", commands);
+        for (char* name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+            int known = 0;
+            for (int i = 0; i < count; i++) {
+                if (strcasecmp(name, command_type_name(types[i])) == 0) {
+                    enabled[i] = 1;
+                    known = 1;
+                }
+            }
+            if (!known) {
+                printf("Error: Command '%s' cannot be used in --solve (MOVE, PUSH, JUMP, CUT, DIG, MOUND, GROW, MAKE, PAINT)\n",
+                       name);
+                return -1;
+            }
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (!enabled[i]) {
+            continue;
+        }
+        if (types[i] == CMD_PAINT) {
+            int used[26] = { 0 };
+            for (int c = 0; c < solver->size; c++) {
+                if (solver->target[c] >= 'a' && solver->target[c] <= 'z') {
+                    used[solver->target[c] - 'a'] = 1;
+                }
+            }
+            for (int c = 0; c < 26; c++) {
+                if (used[c]) {
+                    solve_add_move(solver, CMD_PAINT, 0, 0, (char)('a' + c));
+                }
+            }
+        } else if (types[i] == CMD_JUMP) {
+            for (int n = 2; n <= SOLVE_MAX_JUMP; n++) {
+                for (int d = DIR_UP; d <= DIR_RIGHT; d++) {
+                    solve_add_move(solver, CMD_JUMP, d, n, 0);
+                }
+            }
+        } else {
+            for (int d = DIR_UP; d <= DIR_RIGHT; d++) {
+                solve_add_move(solver, types[i], d, 0, 0);
+            }
+        }
+    }
+    return 0;
+}
+
+static unsigned char solve_encode_cell(const Cell* cell) {
+    int type = SOLVE_EMPTY;
+    for (int t = 0; t < (int)sizeof(solve_type_symbols); t++) {
+        if (solve_type_symbols[t] == (char)cell->type) {
+            type = t;
+        }
+    }
+    int color = (cell->color >= 'a' && cell->color <= 'z') ? cell->color - 'a' + 1 : 0;
+    return (unsigned char)(type | (color << 3));
+}
+
+static Solver* solve_create(const Field* target, int threads, long memory_mb) {
+    Solver* solver = calloc(1, sizeof(Solver));
+    if (solver == NULL) {
+        printf("Error: Cannot allocate solver\n");
+        return NULL;
+    }
+    solver->width = target->width;
+    solver->height = target->height;
+    solver->size = target->width * target->height;
+    for (int x = 0; x < target->width; x++) {
+        for (int y = 0; y < target->height; y++) {
+            const Cell* cell = &target->grid[x][y];
+            solver->target[x * target->height + y] = (cell->color != '\0') ? cell->color : (char)cell->type;
+        }
+    }
+
+    solver->thread_count = threads < 1 ? 1 : (threads > SOLVE_MAX_THREADS ? SOLVE_MAX_THREADS : threads);
+    for (int t = 0; t < solver->thread_count; t++) {
+        solver->workers[t].solver = solver;
+        solver->workers[t].id = t;
+    }
+    solver->memory_limit = (size_t)memory_mb * 1024 * 1024;
+
+    // Множество хешей занимает не больше четверти ограничения памяти
+    size_t slots = SOLVE_MIN_SEEN;
+    while (slots * 2 * sizeof(uint64_t) <= solver->memory_limit / 4) {
+        slots *= 2;
+    }
+    if (solve_reserve(solver, slots * sizeof(uint64_t)) != 0) {
+        printf("Error: Memory limit too small for --solve\n");
+        free(solver);
+        return NULL;
+    }
+    solver->seen = calloc(slots, sizeof(uint64_t));
+    if (solver->seen == NULL) {
+        printf("Error: Cannot allocate solver state set\n");
+        free(solver);
+        return NULL;
+    }
+    solver->seen_mask = slots - 1;
+    solver->seen_limit = (long)(slots / 10 * 7);
+    return solver;
+}
+
+static void solve_destroy(Solver* solver) {
+    for (int t = 0; t < solver->thread_count; t++) {
+        SolveWorker* worker = &solver->workers[t];
+        solve_arena_free(&worker->nodes);
+        solve_arena_free(&worker->cells[0]);
+        solve_arena_free(&worker->cells[1]);
+        free(worker->frontier);
+        free(worker->next);
+    }
+    free(solver->seen);
+    free(solver);
+}
+
+// Запись найденного скрипта: LOAD начального поля и команды от корня
+static int solve_write_script(const Solver* solver, const SolveNode* node, const char* start_filename,
+                              FILE* output) {
+    int depth = 0;
+    for (const SolveNode* n = node; n->parent != NULL; n = n->parent) {
+        depth++;
+    }
+    const SolveMove** path = malloc((depth > 0 ? depth : 1) * sizeof(SolveMove*));
+    if (path == NULL) {
+        printf("Error: Cannot allocate solution\n");
+        return -1;
+    }
+    int i = depth;
+    for (const SolveNode* n = node; n->parent != NULL; n = n->parent) {
+        path[--i] = &solver->moves[n->move];
+    }
+
+    fprintf(output, "// Solution found by --solve: %d commands\n", depth);
+    fprintf(output, "LOAD %s\n", start_filename);
+    for (i = 0; i < depth; i++) {
+        fprintf(output, "%s\n", path[i]->text);
+    }
+    free(path);
+    return depth;
+}
+
+// Поиск кратчайшего скрипта. 0 - скрипт найден
+int solve_run(const char* start_filename, const char* target_filename, const char* script_filename,
+              int threads, long memory_mb, const char* commands) {
+    static Field start, target;
+    field_init(&start);
+    field_init(&target);
+    if (field_load_from_file(&start, start_filename) != 0 || field_load_from_file(&target, target_filename) != 0) {
+        return -1;
+    }
+    if (start.width != target.width || start.height != target.height) {
+        printf("Error: Start field is %dx%d, target field is %dx%d\n",
+               start.width, start.height, target.width, target.height);
+        return -1;
+    }
+    if (start.dino_x == -1 || start.dino_y == -1) {
+        printf("Error: No dino ('#') in start field '%s'\n", start_filename);
+        return -1;
+    }
+
+    Solver* solver = solve_create(&target, threads, memory_mb);
+    if (solver == NULL) {
+        return -1;
+    }
+    if (solve_build_moves(solver, commands) != 0) {
+        solve_destroy(solver);
+        return -1;
+    }
+
+    // Начальное состояние - уровень 0
+    unsigned char cells[MAX_WIDTH * MAX_HEIGHT];
+    for (int x = 0; x < start.width; x++) {
+        for (int y = 0; y < start.height; y++) {
+            cells[x * start.height + y] = solve_encode_cell(&start.grid[x][y]);
+        }
+    }
+    solve_seen_insert(solver, solve_hash(cells, solver->size));
+    solver->level = -1;  // Клетки корня - в арене уровня 0
+    solve_add(solver, &solver->workers[0], NULL, 0, cells, start.dino_x, start.dino_y);
+    solver->level = 0;
+
+    printf("Solving %s -> %s: %dx%d field, %d commands per state, %d threads\n", start_filename,
+           target_filename, solver->width, solver->height, solver->move_count, solver->thread_count);
+    double start_time = get_time_seconds();
+
+    while (!solve_stopped(solver)) {
+        long states = solve_next_level(solver);
+        if (states == 0) {
+            break;
+        }
+        printf("Depth %d: %ld states\n", solver->level, states);
+        solve_expand_level(solver);
+
+        // Клетки раскрытого уровня больше не нужны
+        for (int t = 0; t < solver->thread_count; t++) {
+            solve_arena_reset(&solver->workers[t].cells[solver->level & 1]);
+        }
+        solver->level++;
+    }
+
+    double elapsed = get_time_seconds() - start_time;
+    long states = atomic_load(&solver->seen_count);
+    double memory = atomic_load(&solver->memory_used) / (1024.0 * 1024.0);
+    const SolveNode* found = atomic_load(&solver->found);
+    int result = -1;
+
+    if (found != NULL) {
+        FILE* output = stdout;
+        if (script_filename != NULL) {
+            output = fopen(script_filename, "w");
+            if (output == NULL) {
+                printf("Error: Cannot create output file '%s'\n", script_filename);
+                solve_destroy(solver);
+                return -1;
+            }
+        }
+        int depth = solve_write_script(solver, found, start_filename, output);
+        if (script_filename != NULL) {
+            fclose(output);
+        }
+        if (depth >= 0) {
+            printf("Solution: %d commands (%ld states, %.1f MB reserved, %.3f s)\n", depth, states, memory, elapsed);
+            if (script_filename != NULL) {
+                printf("Script saved to '%s'\n", script_filename);
+            }
+            result = 0;
+        }
+    } else if (atomic_load(&solver->out_of_memory)) {
+        printf("Search stopped at depth %d: memory limit of %ld MB reached (%ld states, %.3f s)\n",
+               solver->level, memory_mb, states, elapsed);
+    } else {
+        printf("No solution: all %ld reachable states explored (%.3f s)\n", states, elapsed);
+    }
+
+    solve_destroy(solver);
+    return result;
+}
@@ -0,0 +1,17 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+// Поиск скрипта (--solve): кратчайшая последовательность команд, переводящая
+// начальное поле (с динозавром) в целевое. Поиск в ширину по уровням, уровень
+// раскрывается несколькими потоками; повторные состояния отсекаются по хешу.
+// Скрипт начинается с LOAD начального поля и выполняется обычным запуском dino.
+
+#define SOLVE_MAX_THREADS 64
+#define SOLVE_MAX_JUMP 4                // Длины JUMP в переборе: 2..SOLVE_MAX_JUMP
+#define SOLVE_DEFAULT_MEMORY_MB 1024    // Ограничение памяти поиска по умолчанию
+
+// Функции поиска. commands - список команд через запятую (MOVE,PUSH,...), NULL - все
+int solve_run(const char* start_filename, const char* target_filename, const char* script_filename,
+              int threads, long memory_mb, const char* commands);
+
+#endif
@@ -0,0 +1,149 @@
+#include "stats.h"
+#include <string.h>
+
+// Номер корзины гистограммы для задержки в наносекундах
+static int stats_bucket(double ns) {
+    unsigned long long value = (ns > 0) ? (unsigned long long)ns : 0;
+    int bucket = 0;
+    
+    while (value > 1 && bucket < STATS_BUCKETS - 1) {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Оценка перцентиля по гистограмме (верхняя граница корзины)
+static double stats_percentile(const long* histogram, long count, double fraction) {
+    if (count == 0) return 0.0;
+    
+    long target = (long)(count * fraction);
+    if (target >= count) target = count - 1;
+    
+    long seen = 0;
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += histogram[i];
+        if (seen > target) {
+            return (double)(1ULL << (i + 1));
+        }
+    }
+    return (double)(1ULL << STATS_BUCKETS);
+}
+
+// Инициализация статистики (сбор выключен)
+void stats_init(ExecutionStats* stats) {
+    if (stats == NULL) return;
+    
+    memset(stats, 0, sizeof(*stats));
+}
+
+// Учет выполнения одной команды
+void stats_record_command(ExecutionStats* stats, CommandType type, double ns, int warning, int error) {
+    if (stats == NULL || type < 0 || type >= CMD_COUNT) return;
+    
+    CommandStats* command = &stats->commands[type];
+    command->count++;
+    command->total_ns += ns;
+    command->histogram[stats_bucket(ns)]++;
+    if (warning) {
+        command->warnings++;
+    } else if (error) {
+        command->errors++;
+    }
+}
+
+// Учет разбора одной строки
+void stats_record_parse(ExecutionStats* stats, double ns) {
+    if (stats == NULL) return;
+    
+    stats->lines_parsed++;
+    stats->parse_ns += ns;
+    stats->parse_histogram[stats_bucket(ns)]++;
+}
+
+// Учет копирования снимка поля для UNDO
+void stats_record_snapshot(ExecutionStats* stats, long bytes) {
+    if (stats == NULL) return;
+    
+    stats->snapshots++;
+    stats->snapshot_bytes += bytes;
+}
+
+// Учет пропущенного снимка (поле не изменилось с прошлого сохранения)
+void stats_record_snapshot_elided(ExecutionStats* stats) {
+    if (stats == NULL) return;
+    
+    stats->snapshots_elided++;
+}
+
+// Вывод статистики в виде таблицы
+void stats_print_table(const ExecutionStats* stats, FILE* output) {
+    if (stats == NULL || output == NULL) return;
+    
+    fprintf(output, "\n=== Execution statistics ===\n");
+    fprintf(output, "%-8s %10s %9s %9s %12s %10s %10s %10s\n",
+            "command", "count", "warnings", "errors", "total ms", "avg ns", "p50 ns", "p99 ns");
+    
+    for (int type = 0; type < CMD_COUNT; type++) {
+        const CommandStats* command = &stats->commands[type];
+        if (command->count == 0) continue;
+        
+        fprintf(output, "%-8s %10ld %9ld %9ld %12.3f %10.0f %10.0f %10.0f\n",
+                command_type_name((CommandType)type), command->count, command->warnings,
+                command->errors, command->total_ns / 1e6, command->total_ns / command->count,
+                stats_percentile(command->histogram, command->count, 0.50),
+                stats_percentile(command->histogram, command->count, 0.99));
+    }
+    
+    if (stats->lines_parsed > 0) {
+        fprintf(output, "%-8s %10ld %9s %9s %12.3f %10.0f %10.0f %10.0f\n",
+                "(parse)", stats->lines_parsed, "-", "-", stats->parse_ns / 1e6,
+                stats->parse_ns / stats->lines_parsed,
+                stats_percentile(stats->parse_histogram, stats->lines_parsed, 0.50),
+                stats_percentile(stats->parse_histogram, stats->lines_parsed, 0.99));
+    }
+    
+    fprintf(output, "Snapshots: %ld, elided: %ld, bytes copied: %lld\n", stats->snapshots,
+            stats->snapshots_elided, stats->snapshot_bytes);
+    fprintf(output, "EXEC and IF times include nested commands\n");
+}
+
+// Вывод гистограммы в JSON (без хвостовых нулей)
+static void stats_write_histogram(const long* histogram, FILE* output) {
+    int last = STATS_BUCKETS - 1;
+    while (last > 0 && histogram[last] == 0) last--;
+    
+    fprintf(output, "[");
+    for (int i = 0; i <= last; i++) {
+        fprintf(output, "%s%ld", (i > 0) ? ", " : "", histogram[i]);
+    }
+    fprintf(output, "]");
+}
+
+// Вывод статистики в формате JSON
+void stats_write_json(const ExecutionStats* stats, FILE* output) {
+    if (stats == NULL || output == NULL) return;
+    
+    fprintf(output, "{\n  \"histogram_buckets\": \"bucket i counts latencies in [2^i, 2^(i+1)) ns\",\n");
+    fprintf(output, "  \"commands\": {");
+    
+    int first = 1;
+    for (int type = 0; type < CMD_COUNT; type++) {
+        const CommandStats* command = &stats->commands[type];
+        if (command->count == 0) continue;
+        
+        fprintf(output, "%s\n    \"%s\": {\"count\": %ld, \"warnings\": %ld, \"errors\": %ld, "
+                "\"total_ns\": %.0f, \"histogram\": ",
+                first ? "" : ",", command_type_name((CommandType)type),
+                command->count, command->warnings, command->errors, command->total_ns);
+        stats_write_histogram(command->histogram, output);
+        fprintf(output, "}");
+        first = 0;
+    }
+    
+    fprintf(output, "\n  },\n  \"parse\": {\"lines\": %ld, \"total_ns\": %.0f, \"histogram\": ",
+            stats->lines_parsed, stats->parse_ns);
+    stats_write_histogram(stats->parse_histogram, output);
+    fprintf(output, "},\n  \"snapshots\": {\"count\": %ld, \"elided\": %ld, \"bytes\": %lld}\n}\n",
+            stats->snapshots, stats->snapshots_elided, stats->snapshot_bytes);
+}
@@ -0,0 +1,39 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "commands.h"
+
+#define STATS_BUCKETS 40  // Корзины гистограммы: [2^i, 2^(i+1)) наносекунд
+
+// Статистика по одному типу команд
+typedef struct {
+    long count;                     // Количество выполнений
+    long warnings;                  // Выполнения с предупреждением
+    long errors;                    // Выполнения с ошибкой (отрицательный код без предупреждения)
+    double total_ns;                // Суммарное время выполнения
+    long histogram[STATS_BUCKETS];  // Логарифмическая гистограмма задержек
+} CommandStats;
+
+// Статистика выполнения программы (--stats)
+typedef struct {
+    int enabled;                        // Включен ли сбор статистики
+    CommandStats commands[CMD_COUNT];   // По типам команд
+    long snapshots;                     // Количество сохранений состояния для UNDO
+    long long snapshot_bytes;           // Байт скопировано при сохранениях
+    long snapshots_elided;              // Сохранений пропущено: поле не изменилось
+    long lines_parsed;                  // Разобрано строк
+    double parse_ns;                    // Суммарное время разбора
+    long parse_histogram[STATS_BUCKETS];
+} ExecutionStats;
+
+// Функции статистики
+void stats_init(ExecutionStats* stats);
+void stats_record_command(ExecutionStats* stats, CommandType type, double ns, int warning, int error);
+void stats_record_parse(ExecutionStats* stats, double ns);
+void stats_record_snapshot(ExecutionStats* stats, long bytes);
+void stats_record_snapshot_elided(ExecutionStats* stats);
+void stats_print_table(const ExecutionStats* stats, FILE* output);
+void stats_write_json(const ExecutionStats* stats, FILE* output);
+
+#endif
@@ -0,0 +1,152 @@
+#include "trace.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Выделение буфера событий (трассировка включается при успехе)
+int trace_init(TraceBuffer* trace, long capacity) {
+    if (trace == NULL) return -1;
+    
+    memset(trace, 0, sizeof(*trace));
+    if (capacity <= 0) {
+        return 0;  // Трассировка выключена
+    }
+    
+    trace->events = malloc(capacity * sizeof(TraceEvent));
+    if (trace->events == NULL) {
+        printf("Error: Cannot allocate trace buffer for %ld events\n", capacity);
+        return -1;
+    }
+    
+    trace->capacity = capacity;
+    trace->start_time = get_time_seconds();
+    trace->enabled = 1;
+    return 0;
+}
+
+// Освобождение буфера событий
+void trace_free(TraceBuffer* trace) {
+    if (trace == NULL) return;
+    
+    free(trace->events);
+    trace->events = NULL;
+    trace->capacity = 0;
+    trace->count = 0;
+    trace->enabled = 0;
+}
+
+// Текущее время трассы в микросекундах
+double trace_now(const TraceBuffer* trace) {
+    return (get_time_seconds() - trace->start_time) * 1e6;
+}
+
+// Следующий свободный слот буфера (NULL, если буфер заполнен)
+static TraceEvent* trace_next_event(TraceBuffer* trace) {
+    if (!trace->enabled) return NULL;
+    
+    if (trace->count >= trace->capacity) {
+        trace->dropped++;
+        return NULL;
+    }
+    return &trace->events[trace->count++];
+}
+
+// Индекс имени файла в таблице (имена повторяются, храним каждое один раз)
+static short trace_file_index(TraceBuffer* trace, const char* filename) {
+    for (int i = 0; i < trace->file_count; i++) {
+        if (strcmp(trace->files[i], filename) == 0) {
+            return (short)i;
+        }
+    }
+    
+    if (trace->file_count >= TRACE_MAX_FILES) {
+        return -1;
+    }
+    
+    strncpy(trace->files[trace->file_count], filename, TRACE_MAX_FILENAME - 1);
+    trace->files[trace->file_count][TRACE_MAX_FILENAME - 1] = '\0';
+    return (short)trace->file_count++;
+}
+
+// Интервал выполнения файла скрипта (записывается по завершении файла,
+// поэтому при переполнении буфера не остается непарных событий)
+void trace_file(TraceBuffer* trace, const char* filename, double start, double duration, int depth) {
+    if (trace == NULL || filename == NULL) return;
+    
+    TraceEvent* event = trace_next_event(trace);
+    if (event == NULL) return;
+    
+    event->name = NULL;
+    event->category = "exec";
+    event->ts = start;
+    event->dur = duration;
+    event->line = 0;
+    event->file_index = trace_file_index(trace, filename);
+    event->phase = 'X';
+    event->depth = (char)depth;
+}
+
+// Завершенный интервал (команда, разбор строки, открытие файла)
+void trace_complete(TraceBuffer* trace, const char* name, const char* category,
+                    double start, double duration, int line, int depth) {
+    if (trace == NULL) return;
+    
+    TraceEvent* event = trace_next_event(trace);
+    if (event == NULL) return;
+    
+    event->name = name;
+    event->category = category;
+    event->ts = start;
+    event->dur = duration;
+    event->line = line;
+    event->file_index = -1;
+    event->phase = 'X';
+    event->depth = (char)depth;
+}
+
+// Вывод строки в JSON с экранированием
+static void trace_write_string(const char* str, FILE* output) {
+    fputc('"', output);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', output);
+            fputc(*str, output);
+        } else if ((unsigned char)*str < 0x20) {
+            fprintf(output, "\\u%04x", *str);
+        } else {
+            fputc(*str, output);
+        }
+    }
+    fputc('"', output);
+}
+
+// Запись трассы в формате Chrome/Perfetto trace-event JSON
+int trace_write_json(const TraceBuffer* trace, FILE* output) {
+    if (trace == NULL || output == NULL) return -1;
+    
+    fprintf(output, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":%ld},\n\"traceEvents\":[\n",
+            trace->dropped);
+    
+    for (long i = 0; i < trace->count; i++) {
+        const TraceEvent* event = &trace->events[i];
+        const char* name = event->name;
+        
+        if (name == NULL) {
+            name = (event->file_index >= 0) ? trace->files[event->file_index] : "(file)";
+        }
+        
+        fprintf(output, "{\"name\":");
+        trace_write_string(name, output);
+        fprintf(output, ",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1",
+                event->category, event->phase, event->ts, event->dur);
+        if (event->line > 0) {
+            fprintf(output, ",\"args\":{\"depth\":%d,\"line\":%d}}", event->depth, event->line);
+        } else {
+            fprintf(output, ",\"args\":{\"depth\":%d}}", event->depth);
+        }
+        fprintf(output, "%s\n", (i + 1 < trace->count) ? "," : "");
+    }
+    
+    fprintf(output, "]}\n");
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+#define TRACE_DEFAULT_CAPACITY (1 << 20)  // Событий в буфере по умолчанию
+#define TRACE_MAX_FILES 64                 // Различных имен файлов в трассе
+#define TRACE_MAX_FILENAME 256
+
+// Событие трассы (формат Chrome trace-event)
+typedef struct {
+    const char* name;       // Имя события (статическая строка) или NULL для файла
+    const char* category;   // Категория: "exec", "command", "parse", "io"
+    double ts;              // Начало в микросекундах от старта трассы
+    double dur;             // Длительность в микросекундах (для фазы 'X')
+    int line;               // Номер строки скрипта (0 - нет)
+    short file_index;       // Индекс имени файла в таблице (-1 - нет)
+    char phase;             // 'X' - завершенный интервал
+    char depth;             // Глубина вложенности EXEC
+} TraceEvent;
+
+// Буфер трассы: события пишутся в заранее выделенный массив
+typedef struct {
+    int enabled;
+    TraceEvent* events;
+    long capacity;
+    long count;
+    long dropped;           // События, не поместившиеся в буфер
+    double start_time;
+    int file_count;
+    char files[TRACE_MAX_FILES][TRACE_MAX_FILENAME];
+} TraceBuffer;
+
+// Функции трассировки
+int trace_init(TraceBuffer* trace, long capacity);
+void trace_free(TraceBuffer* trace);
+double trace_now(const TraceBuffer* trace);
+void trace_file(TraceBuffer* trace, const char* filename, double start, double duration, int depth);
+void trace_complete(TraceBuffer* trace, const char* name, const char* category,
+                    double start, double duration, int line, int depth);
+int trace_write_json(const TraceBuffer* trace, FILE* output);
+
+#endif
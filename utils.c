@@ -1,5 +1,6 @@
 #include "utils.h"
 #include <string.h>
+#include <sys/stat.h>
 
 // Проверка существования файла
 int file_exists(const char* filename) {
@@ -31,4 +32,61 @@ char* read_line(FILE* file, char* buffer, int size) {
     }
     
     return NULL;  // Достигнут конец файла или ошибка чтения
-}
\ No newline at end of file
+}
+
+// Монотонное время в секундах (для замеров производительности)
+double get_time_seconds(void) {
+#ifdef _WIN32
+    return (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+// FNV-1a содержимого файла; 0, если файл не читается
+uint64_t file_content_hash(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    unsigned char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ buffer[i]) * 0x100000001B3ULL;
+        }
+    }
+    fclose(file);
+    return hash;
+}
+
+static int file_stamp_recent(const struct stat* info) {
+    return time(NULL) - info->st_mtim.tv_sec < FILE_RECENT_SECONDS;
+}
+
+// Текущее состояние файла (до его чтения). -1, если файла нет
+int file_stamp_get(const char* filename, FileStamp* stamp) {
+    struct stat info;
+    if (stat(filename, &info) != 0) {
+        return -1;
+    }
+    stamp->mtime = info.st_mtim;
+    stamp->size = info.st_size;
+    stamp->inode = info.st_ino;
+    stamp->content = file_stamp_recent(&info) ? file_content_hash(filename) : 0;
+    return 0;
+}
+
+// 1, если файл не менялся с file_stamp_get: совпадают время изменения
+// (с наносекундами), размер, inode, а у недавно измененного - и содержимое
+int file_stamp_same(const char* filename, const FileStamp* stamp) {
+    struct stat info;
+    if (stat(filename, &info) != 0 ||
+        info.st_mtim.tv_sec != stamp->mtime.tv_sec || info.st_mtim.tv_nsec != stamp->mtime.tv_nsec ||
+        info.st_size != stamp->size || info.st_ino != stamp->inode) {
+        return 0;
+    }
+    return !file_stamp_recent(&info) || file_content_hash(filename) == stamp->content;
+}
@@ -2,9 +2,28 @@
 #define UTILS_H
 
 #include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define FILE_RECENT_SECONDS 2   // Файлы, измененные позже, сравниваются еще и по содержимому
+
+// Состояние файла для кэшей разобранных файлов. Время изменения обновляется
+// с шагом таймера ядра, поэтому запись того же размера вскоре после чтения
+// может его не изменить - у недавно измененного файла хранится хеш содержимого
+typedef struct {
+    struct timespec mtime;
+    off_t size;
+    ino_t inode;
+    uint64_t content;           // FNV-1a содержимого (0 - файл не был недавно изменен)
+} FileStamp;
 
 // Утилиты для работы с файлами и строками
 int file_exists(const char* filename);
 char* read_line(FILE* file, char* buffer, int size);
+double get_time_seconds(void);
+uint64_t file_content_hash(const char* filename);
+int file_stamp_get(const char* filename, FileStamp* stamp);
+int file_stamp_same(const char* filename, const FileStamp* stamp);
 
 #endif
\ No newline at end of file
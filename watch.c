@@ -0,0 +1,452 @@
+#include "watch.h"
+#include "interpreter.h"
+#include "counts.h"
+#include "utils.h"
+#include <strings.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Отслеживаемый файл: состояние при последней проверке и хеш с учетом файлов,
+// на которые он ссылается
+typedef struct {
+    char filename[256];
+    int exists;
+    FileStamp stamp;
+    unsigned generation;        // Пересчет подписей, в котором файл использовался
+    uint64_t hash;
+} WatchFile;
+
+// Поле точки сохранения: два байта на клетку (тип, цвет), по столбцам
+typedef struct {
+    int width, height;
+    int dino_x, dino_y;
+    uint64_t hash;
+    unsigned char* cells;
+} WatchField;
+
+// Состояние контекста перед строкой next_line основного скрипта
+typedef struct {
+    int next_line;
+    int result;                 // Результат последней команды основного скрипта
+    long commands_executed;
+    int field_initialized;
+    int dino_placed;
+    int history_size;
+    int current_history_index;
+    int history_slots[MAX_UNDO_LEVELS];
+    int history_refs[MAX_UNDO_LEVELS];
+    WatchField field;
+    WatchField history[MAX_UNDO_LEVELS];  // Только снимки, на которые ссылается история
+} WatchCheckpoint;
+
+typedef struct {
+    const char* script_filename;
+    const char* output_filename;
+    long checkpoint_lines;
+    InterpreterContext context;
+    ParsedScript script;        // Выполняемая версия основного скрипта
+    uint64_t* signatures;       // Подписи ее строк (текст, номер строки, файлы по ссылкам)
+    int signature_count;
+    WatchFile files[WATCH_MAX_FILES];
+    int file_count;
+    unsigned generation;
+    WatchCheckpoint* checkpoints;
+    int checkpoint_count;
+    int checkpoint_capacity;
+    int runs;
+} Watcher;
+
+#define WATCH_FNV_OFFSET 0xCBF29CE484222325ULL
+#define WATCH_FNV_PRIME 0x100000001B3ULL
+
+static uint64_t watch_hash_bytes(uint64_t hash, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * WATCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+static int watch_pack_field(WatchField* packed, const Field* field) {
+    packed->width = field->width;
+    packed->height = field->height;
+    packed->dino_x = field->dino_x;
+    packed->dino_y = field->dino_y;
+    packed->hash = field->hash;
+    packed->cells = NULL;
+    if (field->width == 0 || field->height == 0) {
+        return 0;
+    }
+
+    packed->cells = malloc((size_t)field->width * field->height * 2);
+    if (packed->cells == NULL) {
+        return -1;
+    }
+    unsigned char* out = packed->cells;
+    for (int x = 0; x < field->width; x++) {
+        for (int y = 0; y < field->height; y++) {
+            *out++ = (unsigned char)field->grid[x][y].type;
+            *out++ = (unsigned char)field->grid[x][y].color;
+        }
+    }
+    return 0;
+}
+
+// Клетки за пределами размеров не трогаются: для поля контекста их очищает field_reset
+static void watch_unpack_field(const WatchField* packed, Field* field) {
+    field->width = packed->width;
+    field->height = packed->height;
+    field->dino_x = packed->dino_x;
+    field->dino_y = packed->dino_y;
+    field->hash = packed->hash;
+
+    const unsigned char* in = packed->cells;
+    for (int x = 0; x < packed->width; x++) {
+        for (int y = 0; y < packed->height; y++) {
+            field->grid[x][y].type = (CellType)*in++;
+            field->grid[x][y].color = (char)*in++;
+        }
+    }
+}
+
+static void watch_free_checkpoint(WatchCheckpoint* checkpoint) {
+    free(checkpoint->field.cells);
+    for (int i = 0; i < MAX_UNDO_LEVELS; i++) {
+        free(checkpoint->history[i].cells);
+    }
+}
+
+// Точка сохранения перед строкой next_line (выполнение остается на вершине основного скрипта)
+static int watch_save_checkpoint(Watcher* watcher, const ExecState* state) {
+    if (watcher->checkpoint_count == watcher->checkpoint_capacity) {
+        int capacity = watcher->checkpoint_capacity ? watcher->checkpoint_capacity * 2 : 16;
+        WatchCheckpoint* checkpoints = realloc(watcher->checkpoints, capacity * sizeof(WatchCheckpoint));
+        if (checkpoints == NULL) {
+            return -1;
+        }
+        watcher->checkpoints = checkpoints;
+        watcher->checkpoint_capacity = capacity;
+    }
+
+    const InterpreterContext* context = &watcher->context;
+    WatchCheckpoint* checkpoint = &watcher->checkpoints[watcher->checkpoint_count];
+    memset(checkpoint, 0, sizeof(WatchCheckpoint));
+    checkpoint->next_line = state->frames[0].next_line;
+    checkpoint->result = state->frames[0].result;
+    checkpoint->commands_executed = context->commands_executed;
+    checkpoint->field_initialized = context->field_initialized;
+    checkpoint->dino_placed = context->dino_placed;
+    checkpoint->history_size = context->history_size;
+    checkpoint->current_history_index = context->current_history_index;
+    memcpy(checkpoint->history_slots, context->history_slots, sizeof(checkpoint->history_slots));
+    memcpy(checkpoint->history_refs, context->history_refs, sizeof(checkpoint->history_refs));
+
+    int result = watch_pack_field(&checkpoint->field, &context->field);
+    for (int slot = 0; slot < MAX_UNDO_LEVELS && result == 0; slot++) {
+        if (context->history_refs[slot] > 0) {
+            result = watch_pack_field(&checkpoint->history[slot], &context->history[slot]);
+        }
+    }
+    if (result != 0) {
+        watch_free_checkpoint(checkpoint);
+        return -1;
+    }
+    watcher->checkpoint_count++;
+    return 0;
+}
+
+// Возврат контекста к точке сохранения. Кэши (пути, шаблоны) остаются: они
+// проверяют поле сами
+static int watch_restore_checkpoint(Watcher* watcher, const WatchCheckpoint* checkpoint) {
+    InterpreterContext* context = &watcher->context;
+
+    if (checkpoint->history_size > 0 && context->history == NULL) {
+        context->history = malloc(MAX_UNDO_LEVELS * sizeof(Field));
+        if (context->history == NULL) {
+            printf("Error: Cannot allocate undo history\n");
+            return -1;
+        }
+    }
+
+    field_reset(&context->field);
+    watch_unpack_field(&checkpoint->field, &context->field);
+    counts_invalidate(context->field.counts);
+    for (int slot = 0; slot < MAX_UNDO_LEVELS; slot++) {
+        if (checkpoint->history_refs[slot] > 0) {
+            watch_unpack_field(&checkpoint->history[slot], &context->history[slot]);
+        }
+    }
+
+    context->field_initialized = checkpoint->field_initialized;
+    context->dino_placed = checkpoint->dino_placed;
+    context->history_size = checkpoint->history_size;
+    context->current_history_index = checkpoint->current_history_index;
+    memcpy(context->history_slots, checkpoint->history_slots, sizeof(context->history_slots));
+    memcpy(context->history_refs, checkpoint->history_refs, sizeof(context->history_refs));
+    context->commands_executed = checkpoint->commands_executed;
+    context->error_occurred = 0;
+    strcpy(context->error_message, "");
+    strcpy(context->current_filename, "");
+    context->exec_depth = 0;
+    context->has_warning = 0;
+    return 0;
+}
+
+// Запись таблицы отслеживаемых файлов (NULL - таблица заполнена)
+static WatchFile* watch_file_entry(Watcher* watcher, const char* filename) {
+    for (int i = 0; i < watcher->file_count; i++) {
+        if (strcmp(watcher->files[i].filename, filename) == 0) {
+            return &watcher->files[i];
+        }
+    }
+    if (watcher->file_count == WATCH_MAX_FILES) {
+        return NULL;
+    }
+    WatchFile* entry = &watcher->files[watcher->file_count++];
+    memset(entry, 0, sizeof(WatchFile));
+    snprintf(entry->filename, sizeof(entry->filename), "%s", filename);
+    return entry;
+}
+
+// Состояние файла на диске (file_stamp_same); 1 - отличается от записанного в entry
+static int watch_file_stat(WatchFile* entry) {
+    if (entry->exists && file_stamp_same(entry->filename, &entry->stamp)) {
+        return 0;
+    }
+    int existed = entry->exists;
+    entry->exists = file_stamp_get(entry->filename, &entry->stamp) == 0;
+    return entry->exists || existed;
+}
+
+// Файл, на который ссылается строка: EXEC, LOAD, STAMP (и они же после THEN)
+static int watch_line_reference(const char* line, char* filename, size_t size) {
+    char buffer[MAX_LINE_LENGTH];
+    char* saveptr = NULL;
+    snprintf(buffer, sizeof(buffer), "%s", line);
+
+    char* token = strtok_r(buffer, " \t\r\n", &saveptr);
+    if (token != NULL && strcasecmp(token, "IF") == 0) {
+        while (token != NULL && strcasecmp(token, "THEN") != 0) {
+            token = strtok_r(NULL, " \t\r\n", &saveptr);
+        }
+        if (token != NULL) {
+            token = strtok_r(NULL, " \t\r\n", &saveptr);
+        }
+    }
+    if (token == NULL ||
+        (strcasecmp(token, "EXEC") != 0 && strcasecmp(token, "LOAD") != 0 && strcasecmp(token, "STAMP") != 0)) {
+        return 0;
+    }
+    token = strtok_r(NULL, " \t\r\n", &saveptr);
+    if (token == NULL) {
+        return 0;
+    }
+    snprintf(filename, size, "%s", token);
+    return 1;
+}
+
+// Хеш содержимого файла вместе с файлами, на которые он ссылается (до MAX_EXEC_DEPTH уровней).
+// В одном пересчете каждый файл читается один раз; на файл, который еще
+// считается (EXEC самого себя), приходится 0
+static uint64_t watch_file_hash(Watcher* watcher, const char* filename, int depth) {
+    WatchFile* entry = watch_file_entry(watcher, filename);
+    if (entry != NULL) {
+        if (entry->generation == watcher->generation) {
+            return entry->hash;
+        }
+        entry->generation = watcher->generation;
+        entry->hash = 0;
+        watch_file_stat(entry);
+    }
+
+    uint64_t hash = WATCH_FNV_OFFSET;
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        hash = ~hash;  // Файла нет
+    } else {
+        char line[MAX_LINE_LENGTH];
+        char reference[MAX_FILENAME_LENGTH];
+        while (fgets(line, sizeof(line), file) != NULL) {
+            hash = watch_hash_bytes(hash, line, strlen(line));
+            if (depth < MAX_EXEC_DEPTH && watch_line_reference(line, reference, sizeof(reference))) {
+                hash = (hash ^ watch_file_hash(watcher, reference, depth + 1)) * WATCH_FNV_PRIME;
+            }
+        }
+        fclose(file);
+    }
+
+    if (entry != NULL) {
+        entry->hash = hash;
+    }
+    return hash;
+}
+
+// Подпись строки основного скрипта: при совпадении подписей строка выполнится так же
+static uint64_t watch_line_signature(Watcher* watcher, const ScriptLine* line) {
+    char reference[MAX_FILENAME_LENGTH];
+    uint64_t hash = watch_hash_bytes(WATCH_FNV_OFFSET, &line->line_number, sizeof(line->line_number));
+    hash = watch_hash_bytes(hash, line->text, strlen(line->text));
+    if (watch_line_reference(line->text, reference, sizeof(reference))) {
+        hash = (hash ^ watch_file_hash(watcher, reference, 1)) * WATCH_FNV_PRIME;
+    }
+    return hash;
+}
+
+// Изменился ли основной скрипт или файл, использованный в последнем пересчете
+static int watch_files_changed(Watcher* watcher) {
+    int changed = 0;
+    for (int i = 0; i < watcher->file_count; i++) {
+        WatchFile* entry = &watcher->files[i];
+        if (entry->generation == watcher->generation && watch_file_stat(entry)) {
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static void watch_save_output(Watcher* watcher) {
+    FILE* output = fopen(watcher->output_filename, "w");
+    if (output == NULL) {
+        printf("Error: Cannot create output file '%s'\n", watcher->output_filename);
+        return;
+    }
+    field_print(&watcher->context.field, output);
+    fclose(output);
+    printf("Final state saved to '%s'\n", watcher->output_filename);
+}
+
+// Выполнение скрипта с первой изменившейся строки first (от последней точки сохранения перед ней)
+static void watch_execute(Watcher* watcher, int first) {
+    ParsedScript* script = &watcher->script;
+
+    while (watcher->checkpoint_count > 1 && watcher->checkpoints[watcher->checkpoint_count - 1].next_line > first) {
+        watch_free_checkpoint(&watcher->checkpoints[--watcher->checkpoint_count]);
+    }
+    const WatchCheckpoint* checkpoint = &watcher->checkpoints[watcher->checkpoint_count - 1];
+    int resume_line = checkpoint->next_line;
+    long resume_commands = checkpoint->commands_executed;
+    if (watch_restore_checkpoint(watcher, checkpoint) != 0) {
+        return;
+    }
+
+    ExecState state;
+    interpreter_start_parsed(&watcher->context, &state, script);
+    state.frames[0].next_line = resume_line;
+    state.frames[0].result = checkpoint->result;
+
+    double start = get_time_seconds();
+    long lines = 0;
+    int next_checkpoint = resume_line + (int)watcher->checkpoint_lines;
+    int checkpoints_failed = 0;
+    while (state.depth > 0) {
+        lines += interpreter_step(&watcher->context, &state, 1);
+
+        // Точки сохранения только между строками основного скрипта и без ошибки
+        if (state.depth != 1 || watcher->context.error_occurred || checkpoints_failed) {
+            continue;
+        }
+        int next_line = state.frames[0].next_line;
+        if (next_line >= next_checkpoint || next_line == script->count) {
+            if (next_line > watcher->checkpoints[watcher->checkpoint_count - 1].next_line &&
+                watch_save_checkpoint(watcher, &state) != 0) {
+                printf("Warning: Cannot allocate watch checkpoint, later edits rerun from an earlier one\n");
+                checkpoints_failed = 1;
+            }
+            next_checkpoint = next_line + (int)watcher->checkpoint_lines;
+        }
+    }
+    double elapsed = get_time_seconds() - start;
+
+    if (watcher->output_filename != NULL && !watcher->context.error_occurred) {
+        watch_save_output(watcher);
+    }
+    watcher->runs++;
+    printf("Watch run %d: resumed at line %d, %ld lines, %ld commands in %.3f s (%d checkpoints)\n",
+           watcher->runs, resume_line < script->count ? script->lines[resume_line].line_number : 0,
+           lines, watcher->context.commands_executed - resume_commands, elapsed, watcher->checkpoint_count);
+}
+
+// Разбор новой версии скрипта, сравнение подписей строк и выполнение изменившегося хвоста
+static void watch_update(Watcher* watcher) {
+    watcher->generation++;
+    WatchFile* entry = watch_file_entry(watcher, watcher->script_filename);
+    entry->generation = watcher->generation;
+    watch_file_stat(entry);
+
+    FILE* file = fopen(watcher->script_filename, "r");
+    if (file == NULL) {
+        printf("Error: Cannot open input file '%s'\n", watcher->script_filename);
+        return;
+    }
+    ParsedScript script;
+    int result = script_parse(file, &script);
+    fclose(file);
+    if (result != 0) {
+        return;
+    }
+    snprintf(script.filename, sizeof(script.filename), "%s", watcher->script_filename);
+
+    uint64_t* signatures = malloc((script.count + 1) * sizeof(uint64_t));
+    if (signatures == NULL) {
+        printf("Error: Cannot allocate memory for script\n");
+        script_free(&script);
+        return;
+    }
+    for (int i = 0; i < script.count; i++) {
+        signatures[i] = watch_line_signature(watcher, &script.lines[i]);
+    }
+
+    int first = 0;
+    while (first < script.count && first < watcher->signature_count &&
+           signatures[first] == watcher->signatures[first]) {
+        first++;
+    }
+    int unchanged = watcher->runs > 0 && first == script.count && first == watcher->signature_count;
+
+    script_free(&watcher->script);
+    watcher->script = script;
+    free(watcher->signatures);
+    watcher->signatures = signatures;
+    watcher->signature_count = script.count;
+
+    if (unchanged) {
+        printf("Watch: no changes in executed lines\n");
+        return;
+    }
+    watch_execute(watcher, first);
+}
+
+// Наблюдение за скриптом: первое выполнение целиком, затем после каждого изменения файлов
+int watch_run(const char* script_filename, const char* output_filename, long checkpoint_lines, double interval) {
+    Watcher* watcher = calloc(1, sizeof(Watcher));
+    if (watcher == NULL) {
+        printf("Error: Cannot allocate watcher\n");
+        return -1;
+    }
+    watcher->script_filename = script_filename;
+    watcher->output_filename = output_filename;
+    watcher->checkpoint_lines = checkpoint_lines > 0 ? checkpoint_lines : WATCH_DEFAULT_CHECKPOINT;
+    interpreter_init(&watcher->context);
+    interpreter_set_display_options(&watcher->context, 0, 0.0);
+
+    // Первая точка - пустой контекст перед первой строкой
+    ExecState empty;
+    empty.frames[0].next_line = 0;
+    empty.frames[0].result = 0;
+    if (watch_save_checkpoint(watcher, &empty) != 0) {
+        printf("Error: Cannot allocate watch checkpoint\n");
+        interpreter_free(&watcher->context);
+        free(watcher);
+        return -1;
+    }
+
+    printf("Watching '%s' (checkpoint every %ld lines, Ctrl+C to stop)\n",
+           script_filename, watcher->checkpoint_lines);
+    for (;;) {
+        watch_update(watcher);
+        fflush(stdout);
+        while (!watch_files_changed(watcher)) {
+            usleep((useconds_t)(interval * 1000000));
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef WATCH_H
+#define WATCH_H
+
+// Режим наблюдения (--watch): скрипт выполняется заново после каждого изменения
+// его файла или файлов, на которые он ссылается (EXEC, LOAD, STAMP, в том числе
+// после THEN и во вложенных файлах). Во время выполнения через каждые
+// checkpoint строк основного скрипта сохраняется состояние контекста (поле,
+// история UNDO); новое выполнение начинается с последней точки перед первой
+// изменившейся строкой. Изменение файла определяется как в кэшах разобранных
+// файлов (file_stamp_same).
+
+#define WATCH_DEFAULT_CHECKPOINT 1000   // Строк основного скрипта между точками сохранения
+#define WATCH_DEFAULT_INTERVAL 0.5      // Период проверки файлов в секундах
+#define WATCH_MAX_FILES 256             // Отслеживаемых файлов, на которые ссылается скрипт
+
+// Функции режима наблюдения (выполняется до завершения процесса)
+int watch_run(const char* script_filename, const char* output_filename, long checkpoint_lines, double interval);
+
+#endif